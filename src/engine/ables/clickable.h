@@ -12,8 +12,23 @@
 
 		void on_mouse_in(SDL_MouseMotionEvent event){}
 		void on_mouse_out(SDL_MouseMotionEvent event){}
+
+	Scenes keep their clickables in a ClickableSet, which indexes click
+	regions in a SpatialGrid. Mouse motion only reaches the clickables
+	under the cursor, those the cursor has just left, and any holding a
+	mouse button pressed inside them. A clickable with an empty region,
+	such as a CardPanel passing events on to its cards, hears all motion.
+	Other mouse events reach every clickable.
 */
+class ClickableSet;
+
 class Clickable {
+	friend class ClickableSet;
+
+	// The set this belongs to, and its place in the set's order.
+	ClickableSet *click_set = NULL;
+	int64_t click_order = 0;
+
 protected:
 	bool mouse_in = false;
 	bool mouse_down_in = false;
@@ -41,7 +56,7 @@ public:
 	bool clickable_disabled = false;
 
 	Clickable(){}
-	virtual ~Clickable(){}
+	virtual ~Clickable();
 
 	Clickable(SDL_Rect click_region){
 		this->click_region = click_region;
@@ -120,9 +135,7 @@ public:
 		}
 	}
 
-	void set_click_region(const SDL_Rect &click_region){
-		this->click_region = click_region;
-	}
+	void set_click_region(const SDL_Rect &click_region);
 
 protected:
 	virtual void on_mouse_click(SDL_MouseButtonEvent event){}
@@ -133,3 +146,180 @@ protected:
 	virtual void on_mouse_in(SDL_MouseMotionEvent event){}
 	virtual void on_mouse_out(SDL_MouseMotionEvent event){}
 };
+
+class ClickableSet {
+	list<Clickable*> items;
+
+	// Clickables with a region are found through the grid. The rest hear
+	// all motion.
+	SpatialGrid<Clickable*> grid;
+	list<Clickable*> everywhere;
+
+	// Clickables the cursor was in after the last event, and those which
+	// had a button pressed in them while it's still held.
+	vector<Clickable*> hovered;
+	vector<Clickable*> captured;
+
+	vector<Clickable*> targets;
+	int64_t order_front = 0, order_back = 0;
+
+	static bool region_empty(const SDL_Rect &rect){
+		return ((rect.w <= 0) || (rect.h <= 0));
+	}
+
+	void index(Clickable *clickable){
+		if(region_empty(clickable->click_region)){
+			grid.remove(clickable);
+
+			if(find(everywhere.begin(), everywhere.end(), clickable) == everywhere.end())
+				everywhere.push_back(clickable);
+		} else {
+			everywhere.remove(clickable);
+			grid.update(clickable, clickable->click_region);
+		}
+	}
+
+	void adopt(Clickable *clickable){
+		if(clickable->click_set && (clickable->click_set != this))
+			clickable->click_set->remove(clickable);
+
+		clickable->click_set = this;
+		index(clickable);
+	}
+
+	static void erase(vector<Clickable*> &v, Clickable *clickable){
+		v.erase(std::remove(v.begin(), v.end(), clickable), v.end());
+	}
+
+	void hovered_rebuild(){
+		hovered.clear();
+
+		for(Clickable *clickable : items)
+			if(clickable->mouse_in)
+				hovered.push_back(clickable);
+	}
+
+	void motion(SDL_Event &event){
+		targets.clear();
+		grid.query_point(event.motion.x, event.motion.y, targets);
+		targets.insert(targets.end(), hovered.begin(), hovered.end());
+		targets.insert(targets.end(), captured.begin(), captured.end());
+		targets.insert(targets.end(), everywhere.begin(), everywhere.end());
+
+		// Keep the order the clickables were added in, as when every one
+		// was told.
+		sort(targets.begin(), targets.end(), [](Clickable *a, Clickable *b){
+			return (a->click_order < b->click_order);
+		});
+		targets.erase(unique(targets.begin(), targets.end()), targets.end());
+
+		hovered.clear();
+
+		for(Clickable *clickable : targets){
+			if(clickable->click_set != this)
+				continue;
+
+			clickable->check_mouse(event);
+
+			if(clickable->mouse_in && (clickable->click_set == this))
+				hovered.push_back(clickable);
+		}
+	}
+
+	void broadcast(SDL_Event &event){
+		// Copied, in case a handler adds or removes clickables.
+		targets.assign(items.begin(), items.end());
+
+		for(Clickable *clickable : targets)
+			if(clickable->click_set == this)
+				clickable->check_mouse(event);
+
+		hovered_rebuild();
+
+		if((event.type == SDL_MOUSEBUTTONDOWN) || (event.type == SDL_FINGERDOWN)){
+			captured.clear();
+
+			for(Clickable *clickable : hovered)
+				captured.push_back(clickable);
+		} else if((event.type == SDL_MOUSEBUTTONUP) || (event.type == SDL_FINGERUP)){
+			captured.clear();
+		}
+	}
+
+public:
+	ClickableSet() :
+		grid(32)
+	{}
+
+	~ClickableSet(){
+		for(Clickable *clickable : items)
+			clickable->click_set = NULL;
+	}
+
+	void push_back(Clickable *clickable){
+		items.push_back(clickable);
+		clickable->click_order = order_back++;
+		adopt(clickable);
+	}
+	void push_front(Clickable *clickable){
+		items.push_front(clickable);
+		clickable->click_order = --order_front;
+		adopt(clickable);
+	}
+
+	void remove(Clickable *clickable){
+		if(clickable->click_set != this)
+			return;
+
+		clickable->click_set = NULL;
+
+		items.remove(clickable);
+		grid.remove(clickable);
+		everywhere.remove(clickable);
+		erase(hovered, clickable);
+		erase(captured, clickable);
+	}
+
+	void clear(){
+		while(items.size())
+			remove(items.front());
+	}
+
+	// The clickable's region has changed.
+	void moved(Clickable *clickable){
+		index(clickable);
+	}
+
+	size_t size() const {
+		return items.size();
+	}
+	bool empty() const {
+		return items.empty();
+	}
+
+	list<Clickable*>::const_iterator begin() const {
+		return items.begin();
+	}
+	list<Clickable*>::const_iterator end() const {
+		return items.end();
+	}
+
+	void check_mouse(SDL_Event event){
+		if(event.type == SDL_MOUSEMOTION)
+			motion(event);
+		else
+			broadcast(event);
+	}
+};
+
+Clickable::~Clickable(){
+	if(click_set)
+		click_set->remove(this);
+}
+
+void Clickable::set_click_region(const SDL_Rect &click_region){
+	this->click_region = click_region;
+
+	if(click_set)
+		click_set->moved(this);
+}
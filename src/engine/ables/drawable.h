@@ -3,8 +3,19 @@
 	mperron(2019)
 
 	An element which can be rendered in someway onto the screen.
+
+	Work is split in two phases. update() advances the element's state by a
+	fixed step, and is called at a steady rate however often frames are
+	drawn. render() only draws, given how far time has moved on towards the
+	next step, so motion can be smoothed between steps. Elements written
+	against draw() alone, which both advance and draw, still work, at the
+	frame rate.
 */
 class Drawable {
+	static void draw_deferred(void *drawable, int ticks){
+		((Drawable*) drawable)->draw(ticks);
+	}
+
 protected:
 	SDL_Renderer *rend;
 
@@ -13,9 +24,57 @@ protected:
 	}
 
 public:
+	// Fraction of an update step which has passed since the last update,
+	// from 0 up to 1. Set by the controller before each frame is drawn.
+	static float render_alpha;
+
 	bool drawable_hidden = false;
 
-	virtual void draw(int ticks) = 0;
+	// Position in the RenderQueue sort order. Higher layers are drawn above
+	// lower ones, and z orders elements within a layer.
+	uint8_t draw_layer = 0;
+	int16_t draw_z = 0;
+
+	// Drawables next to each other in a scene with the same nonzero batch
+	// share a run of the RenderQueue, so their textures are drawn together.
+	// They're no longer drawn in order among themselves, so only share a
+	// batch between elements which don't overlap, such as separate lines of
+	// text.
+	uint16_t draw_batch = 0;
+
+	// Advance by step milliseconds.
+	virtual void update(int step){}
+
+	// Draw the current state, alpha of a step after it was last updated.
+	virtual void render(float alpha){}
+
+	// Draw a frame, ticks milliseconds after the last one.
+	virtual void draw(int ticks){
+		render(render_alpha);
+	}
+
+	// Area covered in world coordinates, for elements placed in a scene's
+	// world with Scene::world_add(). Returns false if the element has no
+	// bounds, in which case it is always drawn.
+	virtual bool bounds(SDL_Rect &out){
+		return false;
+	}
+
+	// Emit draw commands into the render queue. By default the element is
+	// drawn immediately with draw() when its place in the queue is reached.
+	virtual void submit(RenderQueue &queue, int ticks){
+		queue.set_depth(draw_layer, draw_z);
+		queue.callback(draw_deferred, this, ticks);
+	}
+
+	// True if submit() emits only queue commands, with no callback. Only
+	// such elements are drawn through a camera view, since a callback draws
+	// in screen coordinates.
+	virtual bool submits_commands(){
+		return false;
+	}
 
 	virtual ~Drawable(){}
 };
+
+float Drawable::render_alpha = 0.0f;
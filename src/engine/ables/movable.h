@@ -3,10 +3,17 @@
 	mperron(2020)
 
 	An element that moves in 2D space.
+
+	Call movable_update() from update() to advance the movement by a step,
+	and draw at movable_x(alpha), movable_y(alpha) to smooth it between
+	steps.
 */
 class Movable {
 	int x_draw, y_draw;
 
+	// Where the element was drawn before the last step.
+	int x_last, y_last;
+
 protected:
 	int x_prev, x_orig;
 	int y_prev, y_orig;
@@ -17,8 +24,8 @@ public:
 	int movable_time;
 
 	Movable(int x, int y){
-		x_draw = this->x = x_orig = x_prev = x;
-		y_draw = this->y = y_orig = y_prev = y;
+		x_last = x_draw = this->x = x_orig = x_prev = x;
+		y_last = y_draw = this->y = y_orig = y_prev = y;
 
 		progress_translate_x = 32.0f;
 		progress_translate_y = 32.0f;
@@ -42,6 +49,9 @@ public:
 	}
 
 	virtual void movable_update(int ticks){
+		x_last = x_draw;
+		y_last = y_draw;
+
 		x_draw = (
 			(progress_translate_x >= 32.0f) ?
 				(x) :
@@ -57,4 +67,8 @@ public:
 
 	inline int movable_x() const { return x_draw; }
 	inline int movable_y() const { return y_draw; }
+
+	// Position alpha of a step on from the last update.
+	inline int movable_x(float alpha) const { return x_last + (int)((x_draw - x_last) * alpha); }
+	inline int movable_y(float alpha) const { return y_last + (int)((y_draw - y_last) * alpha); }
 };
@@ -0,0 +1,247 @@
+/*
+	Transformable
+	mperron (2026)
+
+	An element with a position relative to a parent element. Moving a
+	parent moves everything attached to it.
+
+	Positions live in a single TransformTree of flat node arrays. Setting a
+	local position marks the node dirty, and once per frame the controller
+	recomputes world positions for dirty nodes and their descendants only,
+	calling on_transform() on each element whose world position changed.
+	Elements without a parent are also moved immediately, so code which
+	positions top level elements sees the result straight away.
+*/
+class Transformable;
+
+class TransformTree {
+	struct Node {
+		Transformable *owner;
+		int parent, first_child, next_sibling, prev_sibling;
+		int local_x, local_y;
+		int world_x, world_y;
+		bool dirty;
+		bool live;
+	};
+
+	vector<Node> nodes;
+	vector<int> nodes_free;
+	vector<int> dirty;
+
+	void mark(int id){
+		if(!nodes[id].dirty){
+			nodes[id].dirty = true;
+			dirty.push_back(id);
+		}
+	}
+
+	void unlink(int id){
+		Node &n = nodes[id];
+
+		if(n.prev_sibling >= 0)
+			nodes[n.prev_sibling].next_sibling = n.next_sibling;
+		else if(n.parent >= 0)
+			nodes[n.parent].first_child = n.next_sibling;
+
+		if(n.next_sibling >= 0)
+			nodes[n.next_sibling].prev_sibling = n.prev_sibling;
+
+		n.parent = n.next_sibling = n.prev_sibling = -1;
+	}
+
+	void link(int id, int parent){
+		Node &n = nodes[id];
+
+		n.parent = parent;
+		n.prev_sibling = -1;
+		n.next_sibling = nodes[parent].first_child;
+
+		if(n.next_sibling >= 0)
+			nodes[n.next_sibling].prev_sibling = id;
+
+		nodes[parent].first_child = id;
+	}
+
+	// Recompute world positions for a subtree.
+	void propagate(int root);
+
+public:
+	static TransformTree &inst(){
+		static TransformTree tree;
+		return tree;
+	}
+
+	int create(Transformable *owner, int x, int y){
+		int id;
+
+		if(nodes_free.size()){
+			id = nodes_free.back();
+			nodes_free.pop_back();
+		} else {
+			id = nodes.size();
+			nodes.push_back(Node());
+		}
+
+		nodes[id] = (Node){ owner, -1, -1, -1, -1, x, y, x, y, false, true };
+		return id;
+	}
+
+	// Children of a destroyed node become top level, and stay where they are.
+	void destroy(int id){
+		Node &n = nodes[id];
+
+		while(n.first_child >= 0){
+			int child = n.first_child;
+			Node &c = nodes[child];
+
+			unlink(child);
+			c.local_x = c.world_x;
+			c.local_y = c.world_y;
+		}
+
+		unlink(id);
+		n.live = false;
+		n.owner = NULL;
+		nodes_free.push_back(id);
+	}
+
+	// Attach to a new parent, or detach with a parent of -1. The local
+	// position is kept, so the element moves with its new parent.
+	void set_parent(int id, int parent){
+		// Refuse to create a cycle.
+		for(int p = parent; p >= 0; p = nodes[p].parent)
+			if(p == id)
+				return;
+
+		unlink(id);
+
+		if(parent >= 0)
+			link(id, parent);
+
+		mark(id);
+	}
+
+	void set_local(int id, int x, int y);
+
+	int get_parent(int id) const { return nodes[id].parent; }
+	int world_x(int id) const { return nodes[id].world_x; }
+	int world_y(int id) const { return nodes[id].world_y; }
+	int local_x(int id) const { return nodes[id].local_x; }
+	int local_y(int id) const { return nodes[id].local_y; }
+
+	// Bring every dirty subtree up to date. Called once per frame.
+	void update(){
+		// Callbacks may move other nodes, which appends to the list.
+		for(size_t i = 0; i < dirty.size(); i++){
+			int id = dirty[i];
+
+			if(!nodes[id].live || !nodes[id].dirty)
+				continue;
+
+			// A dirty ancestor will update this subtree when it's reached.
+			bool covered = false;
+			for(int p = nodes[id].parent; p >= 0; p = nodes[p].parent){
+				if(nodes[p].dirty){
+					covered = true;
+					break;
+				}
+			}
+
+			if(!covered)
+				propagate(id);
+		}
+
+		dirty.clear();
+	}
+};
+
+class Transformable {
+	int m_node;
+
+public:
+	Transformable(int x = 0, int y = 0) :
+		m_node(TransformTree::inst().create(this, x, y))
+	{}
+
+	virtual ~Transformable(){
+		TransformTree::inst().destroy(m_node);
+	}
+
+	// Each element owns its node in the tree, so it can't be copied.
+	Transformable(const Transformable&) = delete;
+	Transformable &operator=(const Transformable&) = delete;
+
+	void transform_set_parent(Transformable *parent){
+		TransformTree::inst().set_parent(m_node, (parent ? parent->m_node : -1));
+	}
+	bool transform_has_parent() const {
+		return (TransformTree::inst().get_parent(m_node) >= 0);
+	}
+
+	// Position relative to the parent, or to the screen if there is none.
+	void transform_set_local(int x, int y){
+		TransformTree::inst().set_local(m_node, x, y);
+	}
+	int transform_local_x() const { return TransformTree::inst().local_x(m_node); }
+	int transform_local_y() const { return TransformTree::inst().local_y(m_node); }
+
+	int transform_world_x() const { return TransformTree::inst().world_x(m_node); }
+	int transform_world_y() const { return TransformTree::inst().world_y(m_node); }
+
+	// Called when the world position changes.
+	virtual void on_transform(int world_x, int world_y){}
+};
+
+void TransformTree::propagate(int root){
+	static vector<int> stack;
+
+	stack.clear();
+	stack.push_back(root);
+
+	while(stack.size()){
+		int id = stack.back();
+		stack.pop_back();
+
+		Node &n = nodes[id];
+		int x = n.local_x, y = n.local_y;
+
+		if(n.parent >= 0){
+			x += nodes[n.parent].world_x;
+			y += nodes[n.parent].world_y;
+		}
+
+		n.dirty = false;
+
+		if((x != n.world_x) || (y != n.world_y)){
+			n.world_x = x;
+			n.world_y = y;
+
+			if(n.owner)
+				n.owner->on_transform(x, y);
+		}
+
+		for(int child = nodes[id].first_child; child >= 0; child = nodes[child].next_sibling)
+			stack.push_back(child);
+	}
+}
+
+void TransformTree::set_local(int id, int x, int y){
+	Node &n = nodes[id];
+
+	if((n.local_x == x) && (n.local_y == y))
+		return;
+
+	n.local_x = x;
+	n.local_y = y;
+
+	// Top level elements move now. Their children follow in update().
+	if((n.parent < 0) && ((n.world_x != x) || (n.world_y != y))){
+		n.world_x = x;
+		n.world_y = y;
+
+		if(n.owner)
+			n.owner->on_transform(x, y);
+	}
+
+	mark(id);
+}
@@ -3,7 +3,8 @@
 	mperron (2022)
 
 	Classes which inherit from this one can receive typed text input, one
-	character at a time, with a keydown method.
+	character at a time, with a keydown method. Text as entered by the user,
+	including through an input method, arrives in UTF-8 with textinput.
 */
 
 class Typable {
@@ -18,4 +19,5 @@ public:
 	virtual ~Typable(){}
 
 	virtual void keydown(SDL_KeyboardEvent event){}
+	virtual void textinput(SDL_TextInputEvent event){}
 };
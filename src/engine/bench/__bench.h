@@ -0,0 +1,20 @@
+/*
+	__bench.h
+	mperron (2026)
+
+	Engine benchmarks. Each is a scene registered under "bench/<name>",
+	and can be run with: game --bench <name>. They're only registered
+	when a benchmark is asked for.
+*/
+#include "bench.h"
+#include "tilemap.h"
+#include "sprites.h"
+#include "text_layout.h"
+#include "lights.h"
+
+void registerBenchScenes(){
+	Scene::reg("bench/tilemap", scene_create<BenchTileMap>);
+	Scene::reg("bench/sprites", scene_create<BenchSprites>);
+	Scene::reg("bench/text_layout", scene_create<BenchTextLayout>);
+	Scene::reg("bench/lights", scene_create<BenchLights>);
+}
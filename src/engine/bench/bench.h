@@ -0,0 +1,72 @@
+/*
+	BenchScene
+	mperron (2026)
+
+	A base class for engine benchmarks. These are ordinary scenes, started
+	with the --bench <name> command line option instead of the game's intro
+	scene. Each runs its workload for a fixed time, then prints frame time
+	statistics and quits.
+*/
+class BenchScene : public Scene {
+	const char *bench_name;
+	int duration;
+	int elapsed = 0;
+
+	uint64_t counter_last = 0;
+	vector<double> frame_ms;
+	vector<double> work_ms;
+
+	static void print_stats(const char *label, vector<double> &ms){
+		if(ms.empty())
+			return;
+
+		double sum = 0;
+		for(double t : ms)
+			sum += t;
+
+		sort(ms.begin(), ms.end());
+
+		cout << "  " << left << setw(8) << label << right << fixed << setprecision(3)
+			<< " avg " << setw(7) << (sum / ms.size()) << " ms"
+			<< "  p50 " << setw(7) << ms[ms.size() / 2]
+			<< "  p99 " << setw(7) << ms[(ms.size() * 99) / 100]
+			<< "  max " << setw(7) << ms.back() << endl;
+	}
+
+protected:
+	// Draw one frame of the workload.
+	virtual void bench_frame(int ticks) = 0;
+
+	// Print any extra results.
+	virtual void bench_report(){}
+
+	BenchScene(Scene::Controller *ctrl, const char *name, int duration = 10000) :
+		Scene(ctrl),
+		bench_name(name),
+		duration(duration)
+	{}
+
+public:
+	void draw(int ticks){
+		uint64_t freq = SDL_GetPerformanceFrequency();
+		uint64_t now = SDL_GetPerformanceCounter();
+
+		if(counter_last)
+			frame_ms.push_back((now - counter_last) * 1000.0 / freq);
+
+		counter_last = now;
+
+		bench_frame(ticks);
+		work_ms.push_back((SDL_GetPerformanceCounter() - now) * 1000.0 / freq);
+
+		elapsed += ticks;
+		if(elapsed >= duration){
+			cout << bench_name << ": " << work_ms.size() << " frames in " << elapsed << " ms" << endl;
+			print_stats("interval", frame_ms);
+			print_stats("work", work_ms);
+			bench_report();
+
+			ctrl->quit();
+		}
+	}
+};
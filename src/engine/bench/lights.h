@@ -0,0 +1,72 @@
+/*
+	BenchLights
+	mperron (2026)
+
+	300 unshadowed point lights drifting over a field of colored blocks,
+	with the light map rebuilt every update step. Also reports the time
+	spent building the light buffer on its own.
+*/
+class BenchLights : public BenchScene {
+	static const int COUNT = 300;
+
+	LightMap *light_map;
+	vector<float> dx, dy;
+
+	uint64_t build_us = 0;
+	int builds = 0;
+
+public:
+	BenchLights(Scene::Controller *ctrl) : BenchScene(ctrl, "lights") {
+		light_map = new LightMap(rend);
+		drawables.push_back(light_map);
+
+		for(int i = 0; i < COUNT; i++){
+			light_map->lights.push_back((LightMap::Light){
+				(float)(rand() % SCREEN_WIDTH), (float)(rand() % SCREEN_HEIGHT),
+				(float)(16 + (rand() % 48)),
+				(SDL_Color){ (uint8_t)(rand() % 256), (uint8_t)(rand() % 256), (uint8_t)(rand() % 256), 0xff },
+				0.5f, false
+			});
+
+			dx.push_back(((rand() % 200) - 100) / 1000.0f);
+			dy.push_back(((rand() % 200) - 100) / 1000.0f);
+		}
+	}
+
+	~BenchLights(){
+		delete light_map;
+	}
+
+	void update(int step){
+		for(int i = 0; i < COUNT; i++){
+			LightMap::Light &light = light_map->lights[i];
+
+			light.x = fmodf(light.x + (dx[i] * step) + SCREEN_WIDTH, SCREEN_WIDTH);
+			light.y = fmodf(light.y + (dy[i] * step) + SCREEN_HEIGHT, SCREEN_HEIGHT);
+		}
+
+		uint64_t start = SDL_GetPerformanceCounter();
+		Scene::update(step);
+		build_us += (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+		builds++;
+	}
+
+	void bench_frame(int ticks){
+		// Blocks under the lights, so there's something to light.
+		for(int y = 0; y < SCREEN_HEIGHT; y += 16){
+			for(int x = 0; x < SCREEN_WIDTH; x += 16){
+				SDL_Rect r = { x, y, 15, 15 };
+
+				SDL_SetRenderDrawColor(rend, 0x80 + ((x * 3) & 0x7f), 0x80 + ((y * 5) & 0x7f), 0xc0, 0xff);
+				SDL_RenderFillRect(rend, &r);
+			}
+		}
+
+		Scene::draw(ticks);
+	}
+
+	void bench_report(){
+		if(builds)
+			cout << fixed << setprecision(3) << "  light build " << ((double) build_us / builds / 1000.0) << " ms per update (" << COUNT << " lights)" << endl;
+	}
+};
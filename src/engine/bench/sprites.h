@@ -0,0 +1,87 @@
+/*
+	BenchSprites
+	mperron (2026)
+
+	Animates 5000 sprites from two generated sprite sheets, drifting across
+	the screen and submitted through the render queue.
+*/
+class BenchSprites : public BenchScene {
+	static const int COUNT = 5000;
+	static const int FRAME = 8;
+
+	SpriteSheet sheets[2];
+	SpriteBatch *batch;
+	vector<SpriteBatch::Sprite> sprites;
+	vector<float> x, y, dx, dy;
+
+public:
+	BenchSprites(Scene::Controller *ctrl) : BenchScene(ctrl, "sprites") {
+		for(int s = 0; s < 2; s++){
+			SpriteSheet &sheet = sheets[s];
+
+			// Eight frames of a square growing and shrinking.
+			sheet.tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, FRAME * 8, FRAME);
+			SDL_SetTextureBlendMode(sheet.tx, SDL_BLENDMODE_BLEND);
+			SDL_SetRenderTarget(rend, sheet.tx);
+			SDL_SetRenderDrawColor(rend, 0, 0, 0, 0);
+			SDL_RenderClear(rend);
+
+			for(int f = 0; f < 8; f++){
+				int size = 1 + ((f < 4) ? f : (7 - f));
+				SDL_Rect r = { (f * FRAME) + (FRAME / 2) - size, (FRAME / 2) - size, size * 2, size * 2 };
+
+				SDL_SetRenderDrawColor(rend, (s ? 0x40 : 0xf0), 0x80 + (f * 0x10), (s ? 0xf0 : 0x40), 0xff);
+				SDL_RenderFillRect(rend, &r);
+			}
+
+			SDL_SetRenderTarget(rend, NULL);
+
+			for(int c = 0; c < 2; c++){
+				SpriteSheet::Clip clip;
+
+				clip.name = (c ? "fast" : "slow");
+				clip.frame_time = (c ? 40 : 120);
+				clip.loop = true;
+
+				for(int f = 0; f < 8; f++)
+					clip.frames.push_back((SDL_Rect){ f * FRAME, 0, FRAME, FRAME });
+
+				sheet.clips.push_back(clip);
+			}
+		}
+
+		batch = new SpriteBatch(rend);
+		drawables.push_back(batch);
+
+		for(int i = 0; i < COUNT; i++){
+			x.push_back(rand() % SCREEN_WIDTH);
+			y.push_back(rand() % SCREEN_HEIGHT);
+			dx.push_back(((rand() % 200) - 100) / 1000.0f);
+			dy.push_back(((rand() % 200) - 100) / 1000.0f);
+
+			sprites.push_back(batch->add(&sheets[i % 2], (i / 2) % 2, x[i], y[i]));
+		}
+	}
+
+	~BenchSprites(){
+		delete batch;
+	}
+
+	void bench_frame(int ticks){
+		for(int i = 0; i < COUNT; i++){
+			x[i] = fmodf(x[i] + (dx[i] * ticks) + SCREEN_WIDTH, SCREEN_WIDTH);
+			y[i] = fmodf(y[i] + (dy[i] * ticks) + SCREEN_HEIGHT, SCREEN_HEIGHT);
+
+			batch->set_pos(sprites[i], x[i], y[i]);
+		}
+
+		Scene::draw(ticks);
+	}
+
+	void bench_report(){
+		RenderQueue::Stats &stats = ctrl->render_queue().stats;
+
+		cout << "  last frame: " << stats.commands << " commands, " << stats.texture_switches << " texture switches, "
+			<< "sort " << stats.sort_us << " us, execute " << stats.execute_us << " us" << endl;
+	}
+};
@@ -0,0 +1,82 @@
+/*
+	BenchTextLayout
+	mperron (2026)
+
+	Text layout under the usual kinds of churn: a long log which grows by a
+	line every frame, a paragraph with one word changing every frame, and a
+	counter updated every frame.
+*/
+class BenchTextLayout : public BenchScene {
+	PicoText *log, *paragraph, *counter;
+	string paragraph_text;
+	int frame = 0;
+
+	uint64_t append_us = 0, edit_us = 0, number_us = 0;
+
+	static uint64_t elapsed_us(uint64_t start){
+		return (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+	}
+
+public:
+	BenchTextLayout(Scene::Controller *ctrl) : BenchScene(ctrl, "text_layout") {
+		string text;
+
+		// Around 256 KB of wrapped text to start with.
+		while(text.size() < (256 * 1024))
+			text += "the quick brown fox jumps over the lazy dog, line " + to_string(text.size()) + ".\n";
+
+		log = new PicoText(rend, (SDL_Rect){ 4, 4, SCREEN_WIDTH - 8, SCREEN_HEIGHT - 40 }, text);
+		log->set_scroll(log->get_line_count());
+
+		for(int i = 0; i < 40; i++)
+			paragraph_text += "word" + to_string(i) + " ";
+
+		paragraph = new PicoText(rend, (SDL_Rect){ 4, SCREEN_HEIGHT - 34, SCREEN_WIDTH - 8, 24 }, paragraph_text);
+		counter = new PicoText(rend, (SDL_Rect){ 4, SCREEN_HEIGHT - 9, 100, 7 }, "0");
+
+		// The boxes don't overlap, so their text can be drawn together.
+		log->draw_batch = paragraph->draw_batch = counter->draw_batch = 1;
+
+		drawables.push_back(log);
+		drawables.push_back(paragraph);
+		drawables.push_back(counter);
+	}
+
+	~BenchTextLayout(){
+		delete log;
+		delete paragraph;
+		delete counter;
+	}
+
+	void bench_frame(int ticks){
+		uint64_t start = SDL_GetPerformanceCounter();
+		log->append("frame " + to_string(frame) + " appended to the end of the log.\n");
+		log->set_scroll(log->get_line_count());
+		append_us += elapsed_us(start);
+
+		// Lengthen one word in the middle of the paragraph.
+		string text = paragraph_text;
+		text.insert(text.size() / 2, string(frame % 8, 'x'));
+
+		start = SDL_GetPerformanceCounter();
+		paragraph->set_message(text);
+		edit_us += elapsed_us(start);
+
+		start = SDL_GetPerformanceCounter();
+		counter->set_number(frame * 37);
+		number_us += elapsed_us(start);
+
+		frame++;
+		Scene::draw(ticks);
+	}
+
+	void bench_report(){
+		if(!frame)
+			return;
+
+		cout << fixed << setprecision(2)
+			<< "  append " << ((double) append_us / frame) << " us, edit " << ((double) edit_us / frame)
+			<< " us, number " << ((double) number_us / frame) << " us per frame ("
+			<< log->get_line_count() << " log lines)" << endl;
+	}
+};
@@ -0,0 +1,83 @@
+/*
+	BenchTileMap
+	mperron (2026)
+
+	Scrolls diagonally across a 4096x4096 tile map of random tiles, changing
+	a few tiles in view every frame so that chunks are re-baked as well as
+	streamed in.
+*/
+class BenchTileMap : public BenchScene {
+	static const int MAP_SIZE = 4096;
+	static const int TILE = 16;
+
+	SDL_Texture *tileset;
+	TileMap *map;
+	float view_x = 0, view_y = 0;
+	uint32_t seed = 0x2545f491;
+
+	long chunks_drawn = 0, bakes = 0, frames = 0;
+
+	uint32_t rand_next(){
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+public:
+	BenchTileMap(Scene::Controller *ctrl) : BenchScene(ctrl, "tilemap") {
+		// Generate a tileset of 16 flat colored tiles.
+		tileset = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, TILE * 16, TILE);
+		SDL_SetRenderTarget(rend, tileset);
+
+		for(int i = 0; i < 16; i++){
+			SDL_Rect tile = { i * TILE, 0, TILE, TILE };
+
+			SDL_SetRenderDrawColor(rend, (i * 53) & 0xff, (i * 97) & 0xff, (i * 31) & 0xff, 0xff);
+			SDL_RenderFillRect(rend, &tile);
+			SDL_SetRenderDrawColor(rend, 0, 0, 0, 0xff);
+			SDL_RenderDrawRect(rend, &tile);
+		}
+
+		SDL_SetRenderTarget(rend, NULL);
+
+		map = new TileMap(rend, MAP_SIZE, MAP_SIZE, tileset, TILE, TILE);
+
+		for(int y = 0; y < MAP_SIZE; y++)
+			for(int x = 0; x < MAP_SIZE; x++)
+				map->set_tile(x, y, (rand_next() % 17));
+	}
+
+	~BenchTileMap(){
+		delete map;
+		SDL_DestroyTexture(tileset);
+	}
+
+	void bench_frame(int ticks){
+		// Scroll at 600 pixels per second, wrapping around the map.
+		float span = (MAP_SIZE * TILE) - (2 * SCREEN_WIDTH);
+
+		view_x = fmodf(view_x + (ticks * 0.6f), span);
+		view_y = fmodf(view_y + (ticks * 0.3f), span);
+		map->set_view(view_x, view_y);
+
+		for(int i = 0; i < 4; i++){
+			map->set_tile(
+				((int) view_x / TILE) + (rand_next() % (SCREEN_WIDTH / TILE)),
+				((int) view_y / TILE) + (rand_next() % (SCREEN_HEIGHT / TILE)),
+				(rand_next() % 17)
+			);
+		}
+
+		map->draw(ticks);
+
+		chunks_drawn += map->chunks_drawn;
+		bakes += map->bakes;
+		frames++;
+	}
+
+	void bench_report(){
+		if(frames)
+			cout << fixed << setprecision(2) << "  chunks drawn " << ((double) chunks_drawn / frames) << "/frame, baked " << ((double) bakes / frames) << "/frame" << endl;
+	}
+};
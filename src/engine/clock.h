@@ -0,0 +1,185 @@
+/*
+	FrameClock, FramePacer
+	mperron (2026)
+
+	Frame timing from the performance counter rather than SDL_GetTicks,
+	which only counts whole milliseconds.
+
+	FrameClock measures each frame in microseconds. Drawables are still
+	given whole milliseconds, but the part of a millisecond left over is
+	carried into the next frame, so over time no ticks are lost or gained.
+
+	FramePacer holds the loop to a target rate. Frames are due at fixed
+	deadlines rather than a fixed delay after the last one, so errors don't
+	add up. SDL_Delay can overshoot by a millisecond or two, so it is only
+	used to sleep until shortly before the deadline, and the rest is spent
+	yielding until it arrives.
+*/
+class FrameClock {
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	// Time handed out so far, since start.
+	uint64_t total_ms = 0, total_us = 0;
+
+public:
+	// Length of the last frame.
+	uint64_t delta_us = 0;
+
+	// Counter ticks to microseconds, without overflowing on long runs.
+	static uint64_t to_us(uint64_t counter, uint64_t freq){
+		return ((counter / freq) * 1000000) + ((counter % freq) * 1000000 / freq);
+	}
+
+	// Start counting from now.
+	void reset(){
+		start = SDL_GetPerformanceCounter();
+		total_ms = total_us = delta_us = 0;
+	}
+
+	// Start a new frame. Returns the whole milliseconds since the last one.
+	int tick(){
+		uint64_t now_us = to_us(SDL_GetPerformanceCounter() - start, freq);
+		uint64_t now_ms = (now_us / 1000);
+		int ms = (int)(now_ms - total_ms);
+
+		delta_us = (now_us - total_us);
+		total_us = now_us;
+		total_ms = now_ms;
+
+		return ms;
+	}
+};
+
+class FramePacer {
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t period = 0;
+	uint64_t deadline = 0, woke_at = 0;
+
+	// Frame intervals since the last report, and how many frames started
+	// after their deadline.
+	double dev_sum = 0;
+	uint64_t dev_max = 0;
+	int intervals = 0, late = 0;
+	uint32_t report_at = 0;
+
+	// Time before the deadline at which sleeping gives way to yielding.
+	uint64_t spin_us = 2000;
+
+	int rate = SCREEN_FPS;
+
+	// Average and worst distance of a frame from the target period, over
+	// the last report window.
+	double jitter_avg = 0;
+	uint64_t jitter_worst = 0;
+
+	uint64_t counter_us(uint64_t counter){
+		return FrameClock::to_us(counter, freq);
+	}
+
+	void measure(uint64_t now){
+		if(woke_at){
+			uint64_t interval = counter_us(now - woke_at);
+			uint64_t target = counter_us(period);
+			uint64_t dev = ((interval > target) ? (interval - target) : (target - interval));
+
+			dev_sum += dev;
+			dev_max = max(dev_max, dev);
+			intervals++;
+		}
+
+		woke_at = now;
+
+		uint32_t ticks = SDL_GetTicks();
+		if(!report_at)
+			report_at = ticks + 5000;
+
+		if(intervals && (ticks >= report_at)){
+			jitter_avg = (dev_sum / intervals);
+			jitter_worst = dev_max;
+
+			if(report)
+				cout << "Frame pacing: " << rate << " Hz, jitter avg " << (int) jitter_avg << " us, max " << jitter_worst << " us, " << late << " late of " << intervals << " frames" << endl;
+
+			dev_sum = 0;
+			dev_max = 0;
+			intervals = late = 0;
+			report_at = ticks + 5000;
+		}
+	}
+
+public:
+	// Print the jitter statistics every five seconds.
+	bool report = false;
+
+	FramePacer(){
+		set_rate(SCREEN_FPS);
+	}
+
+	// Target frames per second. Zero or less runs unpaced.
+	void set_rate(int hz){
+		rate = hz;
+		period = ((hz > 0) ? (freq / hz) : 0);
+		deadline = 0;
+	}
+	int get_rate(){
+		return rate;
+	}
+
+	// Time each frame has, or zero when unpaced.
+	uint64_t period_us(){
+		return (period ? counter_us(period) : 0);
+	}
+
+	void set_spin(uint64_t us){
+		spin_us = us;
+	}
+
+	double jitter_us(){
+		return jitter_avg;
+	}
+	uint64_t jitter_max_us(){
+		return jitter_worst;
+	}
+
+	// Wait until the next frame is due.
+	void wait(){
+		uint64_t now = SDL_GetPerformanceCounter();
+
+		if(!period){
+			measure(now);
+			return;
+		}
+
+		if(!deadline)
+			deadline = now;
+
+		deadline += period;
+
+		// Too far behind to catch up, so start again from now rather than
+		// rushing through frames.
+		if(now >= (deadline + period)){
+			deadline = now;
+			late++;
+			measure(now);
+			return;
+		}
+
+		if(now > deadline)
+			late++;
+
+#ifndef __EMSCRIPTEN__
+		if(now < deadline){
+			uint64_t remaining_us = counter_us(deadline - now);
+
+			if(remaining_us > spin_us)
+				SDL_Delay((uint32_t)((remaining_us - spin_us) / 1000));
+
+			while(SDL_GetPerformanceCounter() < deadline)
+				this_thread::yield();
+		}
+#endif
+
+		measure(SDL_GetPerformanceCounter());
+	}
+};
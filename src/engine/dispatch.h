@@ -0,0 +1,128 @@
+/*
+	MainQueue
+	mperron (2026)
+
+	Work handed back to the main thread. SDL's renderer and textures, and
+	anything else tied to the window, may only be used from the thread which
+	created them, so a worker with a finished result posts a function here
+	and gets a future for its return value.
+
+	Any thread may post. Posting never takes a lock: each function is linked
+	onto the end of a list with one atomic swap. The main thread runs what
+	has been posted once per frame, until the queue is empty or the frame's
+	time budget is spent; anything left over runs next frame.
+
+	The once-a-frame drain is the only place posted functions run, so they
+	never interrupt an update. A job run on the main thread which posts
+	has its function run straight away. A job on a worker must not wait on
+	its future while the main thread waits on that job's JobCounter, as
+	nothing would run the function until the wait was over.
+*/
+class MainQueue {
+	struct Node {
+		atomic<Node*> next{NULL};
+		function<void()> fn;
+	};
+
+	// Producers swap themselves in at head; the main thread follows the
+	// links from tail. tail is always a node which has already run.
+	atomic<Node*> head;
+	Node *tail;
+
+	thread::id main_id;
+
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t budget_us = 2000;
+
+	MainQueue() :
+		main_id(this_thread::get_id())
+	{
+		tail = new Node();
+		head = tail;
+	}
+
+	void push(function<void()> fn){
+		Node *node = new Node();
+		node->fn = fn;
+
+		Node *prev = head.exchange(node, memory_order_acq_rel);
+		prev->next.store(node, memory_order_release);
+	}
+
+	// Run the oldest posted function, if there is one.
+	bool run_one(){
+		if(!is_main())
+			return false;
+
+		Node *next = tail->next.load(memory_order_acquire);
+
+		if(!next)
+			return false;
+
+		function<void()> fn;
+		fn.swap(next->fn);
+
+		delete tail;
+		tail = next;
+
+		fn();
+		ran++;
+
+		return true;
+	}
+
+public:
+	// Counts of functions run, and of frames which ran out of budget with
+	// work still waiting.
+	size_t ran = 0, deferred = 0;
+
+	// Call first from the main thread, so it knows which thread that is.
+	static MainQueue &inst(){
+		static MainQueue *queue = new MainQueue();
+		return *queue;
+	}
+
+	bool is_main(){
+		return (this_thread::get_id() == main_id);
+	}
+
+	// Time the main thread may spend on posted work each frame.
+	void set_budget(uint64_t us){
+		budget_us = us;
+	}
+
+	// Run fn on the main thread. The future holds its result, or whatever
+	// it threw. Posted from the main thread, such as by a job it ran while
+	// waiting, fn runs straight away.
+	template<typename F>
+	auto post(F fn) -> future<decltype(fn())> {
+		auto task = make_shared<packaged_task<decltype(fn())()>>(fn);
+		auto result = task->get_future();
+
+		if(is_main()){
+			(*task)();
+			ran++;
+		} else {
+			push([task](){
+				(*task)();
+			});
+		}
+
+		return result;
+	}
+
+	// Run posted functions until none are left or the budget is spent. At
+	// least one runs, so the queue always makes progress.
+	void drain(){
+		uint64_t start = SDL_GetPerformanceCounter();
+
+		while(run_one()){
+			if(((SDL_GetPerformanceCounter() - start) * 1000000 / freq) >= budget_us){
+				if(tail->next.load(memory_order_acquire))
+					deferred++;
+
+				break;
+			}
+		}
+	}
+};
@@ -0,0 +1,258 @@
+/*
+	LightMap
+	mperron (2026)
+
+	Dynamic point lights over the scene. Lights are accumulated on the CPU
+	into a light buffer at a quarter of the logical resolution, which is
+	uploaded once per frame and multiplied over everything drawn beneath it
+	in a single SDL_BLENDMODE_MOD copy, with linear filtering smoothing out
+	the low resolution.
+
+	Light levels run from 0.0 (black) to 1.0 (unlit scene color). An
+	optional solid mask, at the light buffer's resolution, casts shadows for
+	lights which have shadows enabled.
+
+	The light buffer is built in update(), and only when the lights, the
+	ambient color or the solid mask have changed since it was last built,
+	so draw() just uploads and copies it.
+*/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+class LightMap : public Drawable {
+public:
+	static const int SCALE = 4;
+	static const int LW = (SCREEN_WIDTH / SCALE);
+	static const int LH = (SCREEN_HEIGHT / SCALE);
+
+	struct Light {
+		float x, y;
+		float radius;
+		SDL_Color color;
+		float intensity;
+		bool shadows;
+	};
+
+	vector<Light> lights;
+	SDL_Color ambient = { 0x20, 0x20, 0x30, 0xff };
+
+private:
+	float buf_r[LW * LH], buf_g[LW * LH], buf_b[LW * LH];
+	uint8_t solid[LW * LH];
+	bool has_solids = false;
+
+	uint32_t pixels[LW * LH];
+	bool pixels_dirty = false;
+	SDL_Texture *tx = NULL;
+
+	// What the light buffer was last built from.
+	vector<Light> lights_built;
+	SDL_Color ambient_built = { 0, 0, 0, 0 };
+	bool built = false, solids_changed = false;
+
+	// Set once update() has been called. Until then, the buffer is built as
+	// it's drawn.
+	bool update_driven = false;
+
+	static bool same(const Light &a, const Light &b){
+		return (
+			(a.x == b.x) && (a.y == b.y) && (a.radius == b.radius) && (a.intensity == b.intensity) &&
+			(a.color.r == b.color.r) && (a.color.g == b.color.g) && (a.color.b == b.color.b) &&
+			(a.shadows == b.shadows)
+		);
+	}
+
+	bool changed(){
+		if(!built || solids_changed || (lights.size() != lights_built.size()))
+			return true;
+
+		if((ambient.r != ambient_built.r) || (ambient.g != ambient_built.g) || (ambient.b != ambient_built.b))
+			return true;
+
+		for(size_t i = 0; i < lights.size(); i++)
+			if(!same(lights[i], lights_built[i]))
+				return true;
+
+		return false;
+	}
+
+	void build(){
+		int n = (LW * LH);
+
+		fill(buf_r, buf_r + n, ambient.r / 255.0f);
+		fill(buf_g, buf_g + n, ambient.g / 255.0f);
+		fill(buf_b, buf_b + n, ambient.b / 255.0f);
+
+		for(const Light &light : lights)
+			accumulate(light);
+
+		for(int i = 0; i < n; i++){
+			uint32_t r = (uint32_t)(min(1.0f, buf_r[i]) * 255.0f);
+			uint32_t g = (uint32_t)(min(1.0f, buf_g[i]) * 255.0f);
+			uint32_t b = (uint32_t)(min(1.0f, buf_b[i]) * 255.0f);
+
+			pixels[i] = ((0xffu << 24) | (r << 16) | (g << 8) | b);
+		}
+
+		lights_built = lights;
+		ambient_built = ambient;
+		built = pixels_dirty = true;
+		solids_changed = false;
+	}
+
+	// True if nothing solid lies between light texel (lx, ly) and (x, y).
+	bool visible(int lx, int ly, int x, int y){
+		int dx = abs(x - lx), dy = -abs(y - ly);
+		int sx = ((lx < x) ? 1 : -1), sy = ((ly < y) ? 1 : -1);
+		int err = dx + dy;
+
+		while((lx != x) || (ly != y)){
+			if(solid[(ly * LW) + lx])
+				return false;
+
+			int e2 = 2 * err;
+			if(e2 >= dy){ err += dy; lx += sx; }
+			if(e2 <= dx){ err += dx; ly += sy; }
+		}
+
+		return true;
+	}
+
+	bool solids_in(int x0, int y0, int x1, int y1){
+		for(int y = y0; y <= y1; y++)
+			for(int x = x0; x <= x1; x++)
+				if(solid[(y * LW) + x])
+					return true;
+
+		return false;
+	}
+
+	void accumulate(const Light &light){
+		if((light.radius <= 0.0f) || (light.intensity <= 0.0f))
+			return;
+
+		// Work in light buffer texels from here on.
+		float lx = light.x / SCALE, ly = light.y / SCALE, r = light.radius / SCALE;
+		int x0 = max(0, (int)(lx - r)), x1 = min(LW - 1, (int)(lx + r));
+		int y0 = max(0, (int)(ly - r)), y1 = min(LH - 1, (int)(ly + r));
+
+		if((x0 > x1) || (y0 > y1))
+			return;
+
+		float inv_r2 = 1.0f / (r * r);
+		float cr = light.color.r * light.intensity / 255.0f;
+		float cg = light.color.g * light.intensity / 255.0f;
+		float cb = light.color.b * light.intensity / 255.0f;
+
+		bool shadows = (light.shadows && has_solids && solids_in(x0, y0, x1, y1));
+		int lxi = max(0, min(LW - 1, (int) lx)), lyi = max(0, min(LH - 1, (int) ly));
+
+		for(int y = y0; y <= y1; y++){
+			float dy = (y + 0.5f) - ly;
+			float dy2 = dy * dy;
+			int row = (y * LW);
+			int x = x0;
+
+#ifdef __SSE2__
+			if(!shadows){
+				const __m128i step = _mm_setr_epi32(0, 1, 2, 3);
+				const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+				const __m128 vlx = _mm_set1_ps(lx - 0.5f), vdy2 = _mm_set1_ps(dy2), vinv = _mm_set1_ps(inv_r2);
+				const __m128 vr = _mm_set1_ps(cr), vg = _mm_set1_ps(cg), vb = _mm_set1_ps(cb);
+
+				for(; (x + 4) <= (x1 + 1); x += 4){
+					__m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), step)), vlx);
+					__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), vdy2);
+					__m128 f = _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(d2, vinv)));
+					f = _mm_mul_ps(f, f);
+
+					_mm_storeu_ps(buf_r + row + x, _mm_add_ps(_mm_loadu_ps(buf_r + row + x), _mm_mul_ps(f, vr)));
+					_mm_storeu_ps(buf_g + row + x, _mm_add_ps(_mm_loadu_ps(buf_g + row + x), _mm_mul_ps(f, vg)));
+					_mm_storeu_ps(buf_b + row + x, _mm_add_ps(_mm_loadu_ps(buf_b + row + x), _mm_mul_ps(f, vb)));
+				}
+			}
+#endif
+
+			for(; x <= x1; x++){
+				float dx = (x + 0.5f) - lx;
+				float f = 1.0f - ((dx * dx + dy2) * inv_r2);
+
+				if(f <= 0.0f)
+					continue;
+
+				if(shadows && !visible(lxi, lyi, x, y))
+					continue;
+
+				f *= f;
+				buf_r[row + x] += f * cr;
+				buf_g[row + x] += f * cg;
+				buf_b[row + x] += f * cb;
+			}
+		}
+	}
+
+public:
+	LightMap(SDL_Renderer *rend) : Drawable(rend) {
+		memset(solid, 0, sizeof(solid));
+
+		// Filter the light buffer when it's scaled up.
+		const char *hint = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+		string quality = (hint ? hint : "");
+
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+		tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, LW, LH);
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, quality.c_str());
+
+		if(tx)
+			SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_MOD);
+	}
+
+	~LightMap(){
+		if(tx)
+			SDL_DestroyTexture(tx);
+	}
+
+	// Mark the area of screen pixels in rect as solid or clear.
+	void set_solid(SDL_Rect rect, bool is_solid = true){
+		int x0 = max(0, rect.x / SCALE), x1 = min(LW - 1, (rect.x + rect.w - 1) / SCALE);
+		int y0 = max(0, rect.y / SCALE), y1 = min(LH - 1, (rect.y + rect.h - 1) / SCALE);
+
+		for(int y = y0; y <= y1; y++)
+			for(int x = x0; x <= x1; x++)
+				solid[(y * LW) + x] = is_solid;
+
+		if(is_solid)
+			has_solids = true;
+
+		solids_changed = true;
+	}
+	void clear_solid(){
+		memset(solid, 0, sizeof(solid));
+		has_solids = false;
+		solids_changed = true;
+	}
+
+	// Build the light buffer from the lights as they are now, if anything
+	// has changed.
+	void update(int step){
+		update_driven = true;
+
+		if(changed())
+			build();
+	}
+
+	void draw(int ticks){
+		if(!update_driven && changed())
+			build();
+
+		if(tx){
+			if(pixels_dirty){
+				SDL_UpdateTexture(tx, NULL, pixels, LW * 4);
+				pixels_dirty = false;
+			}
+
+			SDL_RenderCopy(rend, tx, NULL, NULL);
+		}
+	}
+};
@@ -14,14 +14,11 @@ protected:
 	}
 
 public:
-	// Your implementation of this function  should return the number of
-	// particles remaining.
-	virtual int update(int ticks){
+	// Your implementation should move the particles in update() and draw
+	// them in render(), and return the number of particles remaining here.
+	virtual int particles(){
 		return 0;
 	}
-	virtual void draw(int ticks){
-		update(ticks);
-	}
 
 	virtual ~ParticleEffect(){}
 };
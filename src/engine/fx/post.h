@@ -0,0 +1,360 @@
+/*
+	PostChain
+	mperron (2026)
+
+	Full screen effects, run on the CPU over the logical SCREEN_WIDTH x
+	SCREEN_HEIGHT frame after the scene is drawn and before it is shown.
+	At this resolution a frame is only ~83k pixels, so vectorized kernels
+	are cheap enough to run every frame, and the chain works the same with
+	the software renderer on machines without a GPU.
+
+	Each PostPass works in place on ARGB8888 pixels. Kernels use SSE2 where
+	it is available and fall back to plain loops elsewhere (e.g. WASM).
+
+	Passes can be left out below a quality tier, so the chain sheds its
+	expensive passes when the QualityGovernor steps down.
+*/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+class PostPass {
+public:
+	const char *name;
+	bool enabled = true;
+
+	// Lowest quality tier the pass runs at.
+	int tier_min = QualityGovernor::TIER_MIN;
+
+	// Time taken by the most recent run, in microseconds.
+	uint64_t time_us = 0;
+
+	PostPass(const char *name) :
+		name(name)
+	{}
+
+	virtual ~PostPass(){}
+
+	virtual void apply(uint32_t *px, int w, int h) = 0;
+
+protected:
+	// Multiply n pixels by per-channel 8-bit factors, with 255 meaning 1.0.
+	// Alpha is forced back to opaque.
+	static void multiply(uint32_t *px, const uint32_t *factors, int n){
+		int i = 0;
+
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+		for(; (i + 4) <= n; i += 4){
+			__m128i p = _mm_loadu_si128((__m128i*)(px + i));
+			__m128i f = _mm_loadu_si128((__m128i*)(factors + i));
+
+			__m128i p_lo = _mm_unpacklo_epi8(p, zero);
+			__m128i p_hi = _mm_unpackhi_epi8(p, zero);
+			__m128i f_lo = _mm_unpacklo_epi8(f, zero);
+			__m128i f_hi = _mm_unpackhi_epi8(f, zero);
+
+			// (p * f + p) >> 8, so a factor of 255 leaves p unchanged.
+			p_lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(p_lo, f_lo), p_lo), 8);
+			p_hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(p_hi, f_hi), p_hi), 8);
+
+			_mm_storeu_si128((__m128i*)(px + i), _mm_or_si128(_mm_packus_epi16(p_lo, p_hi), alpha));
+		}
+#endif
+
+		for(; i < n; i++){
+			uint32_t p = px[i], f = factors[i], out = 0xff000000;
+
+			for(int shift = 0; shift < 24; shift += 8){
+				uint32_t c = (p >> shift) & 0xff;
+				out |= (((c * ((f >> shift) & 0xff)) + c) >> 8) << shift;
+			}
+
+			px[i] = out;
+		}
+	}
+
+	// Saturating add of n pixels.
+	static void add(uint32_t *px, const uint32_t *addend, int n){
+		int i = 0;
+
+#ifdef __SSE2__
+		for(; (i + 4) <= n; i += 4){
+			__m128i p = _mm_loadu_si128((__m128i*)(px + i));
+			__m128i a = _mm_loadu_si128((__m128i*)(addend + i));
+
+			_mm_storeu_si128((__m128i*)(px + i), _mm_adds_epu8(p, a));
+		}
+#endif
+
+		for(; i < n; i++){
+			uint32_t p = px[i], a = addend[i], out = 0;
+
+			for(int shift = 0; shift < 32; shift += 8)
+				out |= min(0xffu, ((p >> shift) & 0xff) + ((a >> shift) & 0xff)) << shift;
+
+			px[i] = out;
+		}
+	}
+};
+
+// Darken every other row, like a CRT.
+class ScanlinePass : public PostPass {
+	vector<uint32_t> row;
+
+public:
+	ScanlinePass(uint8_t strength = 0x60) : PostPass("scanlines") {
+		set_strength(strength);
+	}
+
+	void set_strength(uint8_t strength){
+		uint8_t f = 0xff - strength;
+		row.assign(SCREEN_WIDTH, (0xffu << 24) | (f << 16) | (f << 8) | f);
+	}
+
+	void apply(uint32_t *px, int w, int h){
+		for(int y = 1; y < h; y += 2)
+			multiply(px + (y * w), row.data(), w);
+	}
+};
+
+// Darken towards the corners of the screen.
+class VignettePass : public PostPass {
+	vector<uint32_t> mask;
+
+public:
+	VignettePass(float strength = 0.6f) : PostPass("vignette") {
+		set_strength(strength);
+	}
+
+	void set_strength(float strength){
+		mask.resize(SCREEN_WIDTH * SCREEN_HEIGHT);
+
+		for(int y = 0; y < SCREEN_HEIGHT; y++){
+			for(int x = 0; x < SCREEN_WIDTH; x++){
+				float dx = ((x + 0.5f) / SCREEN_WIDTH) - 0.5f;
+				float dy = ((y + 0.5f) / SCREEN_HEIGHT) - 0.5f;
+				float d = (dx * dx + dy * dy) * 2.0f;
+				uint32_t f = (uint32_t)(255.0f * max(0.0f, 1.0f - (strength * d * d * 4.0f)));
+
+				mask[(y * SCREEN_WIDTH) + x] = ((0xffu << 24) | (f << 16) | (f << 8) | f);
+			}
+		}
+	}
+
+	void apply(uint32_t *px, int w, int h){
+		multiply(px, mask.data(), w * h);
+	}
+};
+
+// Per-channel color curves.
+class ColorGradePass : public PostPass {
+	uint8_t curve_r[256], curve_g[256], curve_b[256];
+
+public:
+	ColorGradePass() : PostPass("grade") {
+		set_levels(1.0f, 0.0f, (SDL_Color){ 0xff, 0xff, 0xff, 0xff });
+	}
+
+	// Contrast around mid gray, brightness offset (-1...1) and a tint
+	// which each channel is multiplied by.
+	void set_levels(float contrast, float brightness, SDL_Color tint){
+		for(int i = 0; i < 256; i++){
+			float v = ((((i / 255.0f) - 0.5f) * contrast) + 0.5f + brightness) * 255.0f;
+
+			curve_r[i] = (uint8_t) max(0.0f, min(255.0f, v * tint.r / 255.0f));
+			curve_g[i] = (uint8_t) max(0.0f, min(255.0f, v * tint.g / 255.0f));
+			curve_b[i] = (uint8_t) max(0.0f, min(255.0f, v * tint.b / 255.0f));
+		}
+	}
+
+	void set_curves(const uint8_t *r, const uint8_t *g, const uint8_t *b){
+		memcpy(curve_r, r, 256);
+		memcpy(curve_g, g, 256);
+		memcpy(curve_b, b, 256);
+	}
+
+	void apply(uint32_t *px, int w, int h){
+		for(int i = 0, n = (w * h); i < n; i++){
+			uint32_t p = px[i];
+
+			px[i] = (
+				(p & 0xff000000) |
+				(curve_r[(p >> 16) & 0xff] << 16) |
+				(curve_g[(p >> 8) & 0xff] << 8) |
+				curve_b[p & 0xff]
+			);
+		}
+	}
+};
+
+// Bright areas bleed light into their surroundings. The bright pass and
+// blur run at quarter resolution, and are added back on at full size.
+class BloomPass : public PostPass {
+	static const int SCALE = 4;
+	static const int BW = (SCREEN_WIDTH / SCALE);
+	static const int BH = (SCREEN_HEIGHT / SCALE);
+
+	uint32_t small[BW * BH];
+	uint32_t blur[BW * BH];
+	uint32_t row[SCREEN_WIDTH];
+
+public:
+	uint8_t threshold;
+	int radius;
+
+	BloomPass(uint8_t threshold = 0xc0, int radius = 2) : PostPass("bloom"),
+		threshold(threshold),
+		radius(radius)
+	{
+		// The most expensive pass, so the first to go.
+		tier_min = 2;
+	}
+
+	void apply(uint32_t *px, int w, int h){
+		// Downsample with a bright pass.
+		for(int y = 0; y < BH; y++){
+			for(int x = 0; x < BW; x++){
+				uint32_t p = px[(y * SCALE * w) + (x * SCALE)], out = 0;
+
+				for(int shift = 0; shift < 24; shift += 8){
+					int c = (int)((p >> shift) & 0xff) - threshold;
+					out |= (uint32_t) max(0, c) << shift;
+				}
+
+				small[(y * BW) + x] = out;
+			}
+		}
+
+		// Separable box blur.
+		for(int pass = 0; pass < 2; pass++){
+			uint32_t *src = (pass ? blur : small);
+			uint32_t *dst = (pass ? small : blur);
+			int step = (pass ? BW : 1);
+			int len = (pass ? BH : BW);
+			int lines = (pass ? BW : BH);
+			int line_step = (pass ? 1 : BW);
+
+			for(int l = 0; l < lines; l++){
+				for(int i = 0; i < len; i++){
+					uint32_t r = 0, g = 0, b = 0, n = 0;
+
+					for(int k = max(0, i - radius); k <= min(len - 1, i + radius); k++){
+						uint32_t p = src[(l * line_step) + (k * step)];
+
+						r += (p >> 16) & 0xff;
+						g += (p >> 8) & 0xff;
+						b += p & 0xff;
+						n++;
+					}
+
+					dst[(l * line_step) + (i * step)] = (((r / n) << 16) | ((g / n) << 8) | (b / n));
+				}
+			}
+		}
+
+		// Upsample and add back onto the frame.
+		for(int y = 0; y < h; y++){
+			const uint32_t *src = &small[min(y / SCALE, BH - 1) * BW];
+
+			for(int x = 0; x < w; x++)
+				row[x] = src[min(x / SCALE, BW - 1)];
+
+			add(px + (y * w), row, w);
+		}
+	}
+};
+
+class PostChain {
+	SDL_Renderer *rend;
+	SDL_Texture *tx = NULL;
+	vector<uint32_t> frame;
+	vector<PostPass*> passes;
+
+	int tier = QualityGovernor::TIER_MAX;
+	QualityGovernor::Subscription quality;
+
+	bool runs(PostPass *pass){
+		return (pass->enabled && (tier >= pass->tier_min));
+	}
+
+public:
+	// Time taken by the whole chain last frame, in microseconds, including
+	// reading the frame and uploading the result.
+	uint64_t time_us = 0;
+
+	PostChain(SDL_Renderer *rend) :
+		rend(rend),
+		frame(SCREEN_WIDTH * SCREEN_HEIGHT)
+	{
+		tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+		quality = QualityGovernor::inst().subscribe([this](int t){
+			tier = t;
+		});
+	}
+
+	~PostChain(){
+		QualityGovernor::inst().unsubscribe(quality);
+
+		for(PostPass *pass : passes)
+			delete pass;
+
+		if(tx)
+			SDL_DestroyTexture(tx);
+	}
+
+	// The chain takes ownership of the pass. Passes run in the order added.
+	PostChain *add(PostPass *pass){
+		passes.push_back(pass);
+		return this;
+	}
+
+	const vector<PostPass*> &get_passes(){
+		return passes;
+	}
+
+	bool active(){
+		for(PostPass *pass : passes)
+			if(runs(pass))
+				return true;
+
+		return false;
+	}
+
+	// The most recently processed frame, in ARGB8888.
+	const uint32_t *pixels(){
+		return frame.data();
+	}
+
+	// Read the frame from the canvas, which must be bound, and run each
+	// enabled pass over it. Returns false if the frame couldn't be read.
+	bool process(Canvas &canvas){
+		uint64_t freq = SDL_GetPerformanceFrequency();
+		uint64_t start = SDL_GetPerformanceCounter();
+
+		if(!tx || !canvas.read(frame.data(), SCREEN_WIDTH * 4))
+			return false;
+
+		for(PostPass *pass : passes){
+			if(!runs(pass))
+				continue;
+
+			uint64_t t = SDL_GetPerformanceCounter();
+			pass->apply(frame.data(), SCREEN_WIDTH, SCREEN_HEIGHT);
+			pass->time_us = (SDL_GetPerformanceCounter() - t) * 1000000 / freq;
+		}
+
+		SDL_UpdateTexture(tx, NULL, frame.data(), SCREEN_WIDTH * 4);
+		time_us = (SDL_GetPerformanceCounter() - start) * 1000000 / freq;
+
+		return true;
+	}
+
+	// Scale the processed frame onto the current target.
+	void present(){
+		SDL_RenderCopy(rend, tx, NULL, NULL);
+	}
+};
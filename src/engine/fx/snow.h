@@ -4,10 +4,14 @@
 
 	A very configurable snow ParticleEffect, which showers a constant
 	stream of particles. Adapted from KrakSnow.js.
+
+	count is the number of flakes at full quality. Lower quality tiers
+	only move and draw a share of them.
 */
 class SnowEffect : public ParticleEffect {
 	class SnowFlake {
 		float cx, cy;
+		float cx_prev, cy_prev;
 		float speed;
 		float offset;
 		float amplitude;
@@ -16,16 +20,31 @@ class SnowEffect : public ParticleEffect {
 
 		SnowEffect *scene;
 
+		// Each flake has its own random numbers, so flakes can be updated
+		// on any thread.
+		uint32_t seed;
+
+		int next(){
+			seed ^= (seed << 13);
+			seed ^= (seed >> 17);
+			seed ^= (seed << 5);
+
+			return (int)(seed & 0x7fffffff);
+		}
+
 		void reset(bool randomY){
-			cx = (rand() % scene->area.w);
-			cy = ((randomY ? (rand() % scene->area.h) : 0) + scene->area.y);
-			speed = (rand() % (scene->speed_max - scene->speed_min) + scene->speed_min);
-			offset = (rand() % ((int)(2 * 3.14159f * 1000))) / 1000.0f;
-			amplitude = (rand() % scene->sway);
-			lum = ((rand() % 0xEF) + 0x10);
+			cx = (next() % scene->area.w);
+			cy = ((randomY ? (next() % scene->area.h) : 0) + scene->area.y);
+			speed = (next() % (scene->speed_max - scene->speed_min) + scene->speed_min);
+			offset = (next() % ((int)(2 * 3.14159f * 1000))) / 1000.0f;
+			amplitude = (next() % scene->sway);
+			lum = ((next() % 0xEF) + 0x10);
+
+			cx_prev = cx;
+			cy_prev = cy;
 		}
 
-		float sway(){
+		float sway(float cx, float cy){
 			float cx_s = cx + (sin(offset + cy / 100.0f) * amplitude);
 
 			while(cx_s < scene->area.x)
@@ -39,26 +58,53 @@ class SnowEffect : public ParticleEffect {
 	public:
 		SnowFlake(SnowEffect *scene, bool randomY){
 			this->scene = scene;
+			seed = (rand() | 1);
 			reset(randomY);
 		}
 
+		// Start again anywhere in the area, as when brought back into use.
+		void respawn(){
+			reset(true);
+		}
+
 		void update(float time, float angle){
+			cx_prev = cx;
+			cy_prev = cy;
+
 			cy += (speed + cos(angle) * scene->wind_force) * time;
-			cx += (((rand() % 1000) / 1000.0f) + sin(angle) * scene->wind_force) * time;
+			cx += (((next() % 1000) / 1000.0f) + sin(angle) * scene->wind_force) * time;
 
-			if(cy > (scene->area.y + scene->area.h)){
+			if(cy > (scene->area.y + scene->area.h))
 				reset(false);
-			} else {
-				SDL_SetRenderDrawColor(scene->rend, lum, lum, lum, 0xa0);
-				SDL_RenderDrawPoint(scene->rend, sway(), cy);
-			}
+		}
+
+		// Draw between the last two positions.
+		void render(float alpha){
+			float x = cx_prev + ((cx - cx_prev) * alpha);
+			float y = cy_prev + ((cy - cy_prev) * alpha);
+
+			SDL_SetRenderDrawColor(scene->rend, lum, lum, lum, 0xa0);
+			SDL_RenderDrawPoint(scene->rend, sway(x, y), y);
 		}
 	};
 
 
-	list<SnowFlake*> flakes;
+	vector<SnowFlake*> flakes;
+	size_t active;
+
+	QualityGovernor::Subscription quality;
 
 	float ticks;
+
+	void set_tier(int tier){
+		size_t active_new = (flakes.size() * (tier + 1) / (QualityGovernor::TIER_MAX + 1));
+
+		// Flakes coming back have been still, so scatter them again.
+		for(size_t i = active; i < active_new; i++)
+			flakes[i]->respawn();
+
+		active = active_new;
+	}
 public:
 	int speed_min, speed_max;
 	int sway;
@@ -80,25 +126,43 @@ public:
 		this->count = count;
 
 		for(int i = 0; i < count; i++)
-			flakes.push_front(new SnowFlake(this, true));
+			flakes.push_back(new SnowFlake(this, true));
+
+		active = flakes.size();
+		quality = QualityGovernor::inst().subscribe([this](int tier){
+			set_tier(tier);
+		});
 
 		ticks = (SDL_GetTicks() / 1000.0f);
 	}
 
 	~SnowEffect(){
+		QualityGovernor::inst().unsubscribe(quality);
+
 		for(auto flake : flakes)
 			delete flake;
 	}
 
-	int update(int ticks){
-		float time = (ticks / 1000.0f);
+	void update(int step){
+		float time = (step / 1000.0f);
 
 		float angle = (wind_angle / 180.0f) * 3.14159f;
-		for(SnowFlake *flake : flakes)
-			flake->update(time, angle);
 
-		// Return the number of active particles.
-		return count;
+		// Large showers are spread across the job system.
+		JobSystem::inst().parallel_for(0, active, 1024, [&](size_t from, size_t to){
+			for(size_t i = from; i < to; i++)
+				flakes[i]->update(time, angle);
+		});
+	}
+
+	void render(float alpha){
+		for(size_t i = 0; i < active; i++)
+			flakes[i]->render(alpha);
+	}
+
+	// Return the number of active particles.
+	int particles(){
+		return (int) active;
 	}
 };
 
@@ -4,11 +4,13 @@
 
 	A mouse-clickable button, which can perform an action.
 */
-class Button : public Drawable, public Clickable {
+class Button : public Drawable, public Clickable, public Transformable {
 	bool hover = false;
 	bool down = false;
 	char alpha = 0xFF;
-	int ticks_toshow = 0;
+
+	// Delay before allowing the button to be clicked again.
+	TimerWheel::Timer show_timer = TimerWheel::NONE;
 
 	SDL_Color color_normal = { 0xb0, 0xb0, 0xb0 };
 	SDL_Color color_down = { 0x40, 0x40, 0x40 };
@@ -23,6 +25,10 @@ class Button : public Drawable, public Clickable {
 			click_region.w, click_region.h - 7
 		}, text);
 		label->set_color(color_label);
+
+		// The label moves with the button.
+		label->transform_set_parent(this);
+		label->transform_set_local(3, (click_region.h / 2) - 3);
 	}
 
 public:
@@ -31,7 +37,7 @@ public:
 		SDL_Renderer *rend,
 		SDL_Rect click_region,
 		string text
-	) : Drawable(rend), Clickable(click_region) {
+	) : Drawable(rend), Clickable(click_region), Transformable(click_region.x, click_region.y) {
 		label_create(text);
 	}
 
@@ -44,11 +50,12 @@ public:
 	) : Drawable(rend), Clickable((SDL_Rect){
 		x, y,
 		((cols * 6) + 5), ((rows * 7) + 8)
-	}) {
+	}), Transformable(x, y) {
 		label_create(text);
 	}
 
 	~Button(){
+		TimerWheel::inst().cancel(show_timer);
 		delete label;
 	}
 
@@ -75,16 +82,6 @@ public:
 	}
 
 	void draw(int ticks){
-		// Delay before allowing the button to be clicked again.
-		if(ticks_toshow > 0){
-			if(ticks_toshow > ticks){
-				ticks_toshow -= ticks;
-			} else {
-				clickable_disabled = false;
-				ticks_toshow = 0;
-			}
-		}
-
 		SDL_Color fill = (down ? color_down : color_normal);
 		SDL_Color bord = (hover ? color_hover : color_label);
 
@@ -100,14 +97,37 @@ public:
 		label->draw(ticks);
 	}
 
+	void submit(RenderQueue &queue, int ticks){
+		SDL_Color fill = (down ? color_down : color_normal);
+		SDL_Color bord = (hover ? color_hover : color_label);
+
+		fill.a = bord.a = alpha;
+
+		queue.set_depth(draw_layer, draw_z);
+		queue.fill(click_region, fill);
+		queue.outline(click_region, bord);
+
+		label->draw_layer = draw_layer;
+		label->draw_z = draw_z;
+		label->submit(queue, ticks);
+	}
+
+	bool submits_commands(){
+		return true;
+	}
+
 	virtual void visible(bool vis){
+		TimerWheel &timers = TimerWheel::inst();
+		timers.cancel_clear(show_timer);
+
 		if(vis){
 			// Show (delayed clickability)
-			ticks_toshow = 100;
+			show_timer = timers.after(100, [this](){
+				clickable_disabled = false;
+			});
 			drawable_hidden = false;
 		} else {
 			// Hide
-			ticks_toshow = 0;
 			drawable_hidden = true;
 			clickable_disabled = true;
 		}
@@ -123,4 +143,16 @@ public:
 	void set_message(string message){
 		label->set_message(message);
 	}
+
+	// Relative to the parent element, if there is one.
+	void set_pos(int x, int y){
+		transform_set_local(x, y);
+	}
+	virtual void on_transform(int world_x, int world_y){
+		SDL_Rect region = click_region;
+
+		region.x = world_x;
+		region.y = world_y;
+		set_click_region(region);
+	}
 };
@@ -18,6 +18,10 @@ public:
 			delete card;
 	}
 
+	void update(int step){
+		if(active_card)
+			active_card->update(step);
+	}
 	void draw(int ticks){
 		if(active_card)
 			active_card->draw(ticks);
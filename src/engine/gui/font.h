@@ -0,0 +1,286 @@
+/*
+	Font, FontAtlas
+	mperron (2026)
+
+	Bitmap fonts. A font sheet is a grid of fixed size cells, starting with
+	the space character and running through ASCII. If a sheet has no lower
+	case letters, they are drawn as capitals.
+
+	Each Font holds a table of source rectangles and advances for all 256
+	byte values, so drawing an ASCII character is a single lookup. Text is
+	UTF-8, and each character takes one cell: one given with map_utf8(),
+	or else the sheet's own cell for code points below 256. Characters
+	beyond the sheet's own are drawn as spaces.
+
+	Every font used with a renderer is packed into one shared FontAtlas
+	texture, so text in any font which shares a render queue run, as text
+	drawables given the same draw_batch do, is drawn without switching
+	textures. Sheets are stacked in columns no taller than the renderer
+	allows; a sheet which can't fit at all is left out, and its font
+	draws nothing useful.
+*/
+class FontAtlas;
+
+class Font {
+	friend class FontAtlas;
+
+public:
+	struct Glyph {
+		SDL_Rect src;
+		int advance;
+	};
+
+	const int c_width, c_height;
+
+private:
+	FontAtlas *atlas;
+
+	// Where the sheet sits in the atlas, and its size in cells.
+	int origin_x = 0, origin_y = 0;
+	int cols = 1, cells = 1;
+
+	Glyph glyphs[256];
+	unordered_map<uint32_t, Glyph> glyphs_utf8;
+
+	Glyph cell(int n){
+		if((n < 0) || (n >= cells))
+			n = 0;
+
+		return (Glyph){
+			(SDL_Rect){ origin_x + ((n % cols) * c_width), origin_y + ((n / cols) * c_height), c_width, c_height },
+			c_width
+		};
+	}
+
+	void build(){
+		bool has_lower = (cells > ('z' - ' '));
+
+		for(int c = 0; c < 256; c++){
+			int ch = c;
+
+			if(!has_lower && (ch >= 'a') && (ch <= 'z'))
+				ch -= 0x20;
+
+			glyphs[c] = cell(ch - ' ');
+		}
+	}
+
+	Font(FontAtlas *atlas, int c_width, int c_height) :
+		c_width(c_width),
+		c_height(c_height),
+		atlas(atlas)
+	{}
+
+public:
+	SDL_Texture *texture();
+
+	const Glyph &glyph(uint8_t c) const {
+		return glyphs[c];
+	}
+
+	bool has_utf8() const {
+		return !glyphs_utf8.empty();
+	}
+
+	// Draw codepoint with cell n of the font sheet.
+	void map_utf8(uint32_t codepoint, int n){
+		if(codepoint < 0x80)
+			glyphs[codepoint] = cell(n);
+		else
+			glyphs_utf8[codepoint] = cell(n);
+	}
+
+	// Glyph for the UTF-8 character at text[i], which is advanced past it.
+	const Glyph &glyph_utf8(const char *text, size_t len, size_t &i) const {
+		uint8_t c = text[i++];
+
+		if(c < 0x80)
+			return glyphs[c];
+
+		int extra = ((c >= 0xf0) ? 3 : ((c >= 0xe0) ? 2 : ((c >= 0xc0) ? 1 : 0)));
+		uint32_t codepoint = (c & (0x3f >> extra));
+
+		for(; extra && (i < len) && ((text[i] & 0xc0) == 0x80); extra--)
+			codepoint = ((codepoint << 6) | (text[i++] & 0x3f));
+
+		if(glyphs_utf8.size()){
+			auto it = glyphs_utf8.find(codepoint);
+
+			if(it != glyphs_utf8.end())
+				return it->second;
+		}
+
+		return ((codepoint < 256) ? glyphs[codepoint] : glyphs[' ']);
+	}
+};
+
+class FontAtlas {
+	SDL_Renderer *rend;
+	SDL_Texture *tx = NULL;
+
+	struct Sheet {
+		string bitmap;
+		Font *font;
+		bool packed;
+	};
+	vector<Sheet> sheets;
+
+	int atlas_w = 0, atlas_h = 0;
+
+	// The column sheets are being stacked in, and how far down it's filled.
+	int column_x = 0, column_y = 0;
+
+	// Largest texture the renderer takes, or zero if it doesn't say.
+	int max_w = 0, max_h = 0;
+
+	// Atlases by renderer. An atlas goes when its renderer is destroyed,
+	// so a new renderer at the same address doesn't find it.
+	static map<SDL_Renderer*, FontAtlas*> &atlases(){
+		static map<SDL_Renderer*, FontAtlas*> *all = NULL;
+
+		if(!all){
+			all = new map<SDL_Renderer*, FontAtlas*>();
+
+			RendererConfig::on_destroy().push_back([](SDL_Renderer *rend){
+				auto it = atlases().find(rend);
+
+				if(it != atlases().end()){
+					delete it->second;
+					atlases().erase(it);
+				}
+			});
+		}
+
+		return *all;
+	}
+
+	~FontAtlas(){
+		for(Sheet &sheet : sheets)
+			delete sheet.font;
+
+		if(tx)
+			SDL_DestroyTexture(tx);
+	}
+
+	FontAtlas(SDL_Renderer *rend) :
+		rend(rend)
+	{
+		SDL_RendererInfo info;
+
+		if(!SDL_GetRendererInfo(rend, &info)){
+			max_w = info.max_texture_width;
+			max_h = info.max_texture_height;
+		}
+	}
+
+	// Find room for a w by h sheet, starting a new column if this one is
+	// full. Returns false if there's none.
+	bool place(Font *font, int w, int h){
+		if(max_h && (column_y > 0) && ((column_y + h) > max_h)){
+			column_x = atlas_w;
+			column_y = 0;
+		}
+
+		if((max_w && ((column_x + w) > max_w)) || (max_h && (h > max_h)))
+			return false;
+
+		font->origin_x = column_x;
+		font->origin_y = column_y;
+
+		column_y += h;
+		atlas_w = max(atlas_w, column_x + w);
+		atlas_h = max(atlas_h, column_y);
+
+		return true;
+	}
+
+	// Copy every sheet into a new texture. Sheets already placed never
+	// move, so the glyphs of fonts already loaded keep their place.
+	void rebuild(){
+		SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, max(1, atlas_w), max(1, atlas_h), 32, SDL_PIXELFORMAT_ARGB8888);
+
+		if(!atlas)
+			return;
+
+		SDL_FillRect(atlas, NULL, 0);
+
+		for(Sheet &sheet : sheets){
+			if(!sheet.packed)
+				continue;
+
+			FileLoader *fl = FileLoader::get(sheet.bitmap);
+			SDL_Surface *sf = (fl ? fl->surface() : NULL);
+
+			if(!sf)
+				continue;
+
+			SDL_Rect dst = { sheet.font->origin_x, sheet.font->origin_y, sf->w, sf->h };
+
+			SDL_SetColorKey(sf, SDL_TRUE, SDL_MapRGB(sf->format, 0xff, 0x00, 0xff));
+			SDL_BlitSurface(sf, NULL, atlas, &dst);
+		}
+
+		SDL_Texture *tx_new = HitchDetector::create_texture(rend, atlas);
+		SDL_FreeSurface(atlas);
+
+		if(tx_new){
+			SDL_SetTextureBlendMode(tx_new, SDL_BLENDMODE_BLEND);
+
+			// Commands queued this frame may still use the old atlas.
+			if(tx)
+				RenderQueue::release(rend, tx);
+
+			tx = tx_new;
+		}
+	}
+
+public:
+	// The atlas for a renderer.
+	static FontAtlas *get(SDL_Renderer *rend){
+		map<SDL_Renderer*, FontAtlas*> &all = atlases();
+		FontAtlas *&atlas = all[rend];
+
+		if(!atlas)
+			atlas = new FontAtlas(rend);
+
+		return atlas;
+	}
+
+	SDL_Texture *texture(){
+		return tx;
+	}
+
+	// Load a font sheet into the atlas, or find it if it's already there.
+	Font *font(const string &bitmap, int c_width, int c_height){
+		for(Sheet &sheet : sheets)
+			if((sheet.bitmap == bitmap) && (sheet.font->c_width == c_width) && (sheet.font->c_height == c_height))
+				return sheet.font;
+
+		FileLoader *fl = FileLoader::get(bitmap);
+		SDL_Surface *sf = (fl ? fl->surface() : NULL);
+		Font *font = new Font(this, c_width, c_height);
+		bool packed = false;
+
+		if(sf){
+			font->cols = max(1, sf->w / c_width);
+			font->cells = max(1, font->cols * (sf->h / c_height));
+
+			packed = place(font, sf->w, sf->h);
+
+			if(!packed)
+				cerr << "Font sheet " << bitmap << " does not fit in the font atlas." << endl;
+		}
+
+		font->build();
+		sheets.push_back((Sheet){ bitmap, font, packed });
+
+		if(packed || !tx)
+			rebuild();
+
+		return font;
+	}
+};
+
+SDL_Texture *Font::texture(){
+	return atlas->texture();
+}
@@ -0,0 +1,294 @@
+/*
+	TextLayout
+	mperron (2026)
+
+	Word wrapping for PicoText. Lines are stored as offsets into the text
+	rather than as copies of it, so laying out text allocates nothing once
+	the line list has grown to size.
+
+	Text is wrapped at chars_perline characters, moving a word to the next
+	line if it would otherwise be split and the line is at least half full.
+	A space or newline at a wrap point is dropped. Text is UTF-8, and a
+	character is one code point however many bytes it takes; a line's len
+	is in bytes.
+
+	Wrapping a line only depends on the text from the start of that line
+	onwards, so after an edit only the lines from just before the edit are
+	wrapped again, stopping as soon as a line starts at the same place it
+	did before. The lines themselves sit in a gap buffer, like the text of
+	a TextArea: lines before the gap hold their start, and lines after it
+	hold their distance from the end of the text, which an edit before
+	them doesn't change. So an edit only touches the lines it wrapped, and
+	the lines the gap moves over to reach it. The text type only needs
+	operator[], so the same layout works over a string or a gap buffer.
+*/
+class TextLayout {
+public:
+	struct Line {
+		size_t start;
+		size_t len;
+	};
+
+	size_t chars_perline = 0;
+
+private:
+	// Lines, with a gap at gap_start. Lines past the gap hold text_size -
+	// start in place of start.
+	vector<Line> buf;
+	size_t gap_start = 0, gap_end = 0;
+	size_t text_size = 0;
+
+	vector<Line> scratch;
+	vector<vector<Line>> parts;
+
+	static bool continuation(char c){
+		return ((c & 0xc0) == 0x80);
+	}
+
+	void move_gap(size_t pos){
+		while(pos < gap_start){
+			Line line = buf[--gap_start];
+
+			line.start = (text_size - line.start);
+			buf[--gap_end] = line;
+		}
+
+		while(pos > gap_start){
+			Line line = buf[gap_end++];
+
+			line.start = (text_size - line.start);
+			buf[gap_start++] = line;
+		}
+	}
+
+	void reserve(size_t n){
+		if((gap_end - gap_start) >= n)
+			return;
+
+		size_t tail = (buf.size() - gap_end);
+		size_t capacity = max(buf.size() * 2, size() + n + 64);
+
+		buf.resize(capacity);
+		memmove(&buf[capacity - tail], &buf[gap_end], sizeof(Line) * tail);
+		gap_end = (capacity - tail);
+	}
+
+	// Make the lines exactly those in out, for text of size characters.
+	void assign(const vector<Line> &out, size_t size){
+		buf.assign(out.begin(), out.end());
+		gap_start = gap_end = buf.size();
+		text_size = size;
+	}
+
+	// Wrap text[pos, size) into out. pos must be the start of a line.
+	// Once a line starts at or after min_start, it is checked against the
+	// existing lines, offset by delta. Returns the index of the first
+	// existing line which matches, or size() if none did.
+	template<typename T>
+	size_t wrap(const T &text, size_t size, size_t pos, size_t min_start, size_t old_from, long delta, vector<Line> &out){
+		size_t line_start = pos, line_len = 0, line_chars = 0;
+		size_t old = old_from, count = this->size();
+		bool wrapped = false;
+
+		out.clear();
+
+		for(size_t i = pos; i < size; i++){
+			char c = text[i];
+
+			// The rest of a character always stays on its line.
+			if(continuation(c)){
+				line_len++;
+				continue;
+			}
+
+			if(wrapped || (c == '\n')){
+				out.push_back((Line){ line_start, line_len });
+
+				wrapped = false;
+				line_len = line_chars = 0;
+
+				// A space or newline at the wrap point is dropped.
+				line_start = (((c == '\n') || (c == ' ')) ? (i + 1) : i);
+
+				// Stop if the rest of the layout is already known.
+				if(line_start >= min_start){
+					while((old < count) && ((long)((*this)[old].start + delta) < (long) line_start))
+						old++;
+
+					if((old < count) && ((long)((*this)[old].start + delta) == (long) line_start))
+						return old;
+				}
+
+				if(line_start > i)
+					continue;
+			}
+
+			line_len++;
+			line_chars++;
+
+			// Automatically wrap at the edge of the text region.
+			if(line_chars > chars_perline)
+				wrapped = true;
+
+			// Wrap if a word won't fit unless the word is really big.
+			if(!wrapped && (c == ' ') && (line_chars > (chars_perline / 2))){
+				size_t next = (i + 1), word = 0;
+
+				while((next < size) && (text[next] != ' ') && (text[next] != '\n')){
+					if(!continuation(text[next]))
+						word++;
+
+					next++;
+				}
+
+				// A word running to the end of the text is counted one short.
+				if((next >= size) && word)
+					word--;
+
+				if((word + line_chars) > chars_perline)
+					wrapped = true;
+			}
+		}
+
+		// Last line.
+		if(line_len)
+			out.push_back((Line){ line_start, line_len });
+
+		return count;
+	}
+
+public:
+	size_t size() const {
+		return (buf.size() - (gap_end - gap_start));
+	}
+	bool empty() const {
+		return !size();
+	}
+
+	Line operator[](size_t i) const {
+		if(i < gap_start)
+			return buf[i];
+
+		const Line &line = buf[i + (gap_end - gap_start)];
+		return (Line){ text_size - line.start, line.len };
+	}
+
+	// Index of the last line starting at or before pos, or 0.
+	size_t line_at(size_t pos) const {
+		size_t lo = 0, hi = size();
+
+		while((hi - lo) > 1){
+			size_t mid = (lo + hi) / 2;
+
+			if((*this)[mid].start <= pos)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		return lo;
+	}
+
+	// Column of pos on line n, and the position of column col, counting
+	// characters rather than bytes.
+	template<typename T>
+	size_t column(const T &text, size_t n, size_t pos) const {
+		Line line = (*this)[n];
+		size_t end = min(pos, line.start + line.len), col = 0;
+
+		for(size_t i = line.start; i < end; i++)
+			if(!continuation(text[i]))
+				col++;
+
+		return col;
+	}
+	template<typename T>
+	size_t position(const T &text, size_t n, size_t col) const {
+		Line line = (*this)[n];
+		size_t i = line.start, end = (line.start + line.len);
+
+		for(; (i < end) && col; col--){
+			i++;
+
+			while((i < end) && continuation(text[i]))
+				i++;
+		}
+
+		return i;
+	}
+
+	// Lay out the whole text. Every newline starts a fresh line, so long
+	// text is cut into pieces after newlines which are wrapped in parallel.
+	template<typename T>
+	void layout(const T &text, size_t size){
+		const size_t piece = (64 * 1024);
+
+		if((size < (piece * 2)) || (JobSystem::inst().threads() <= 1)){
+			wrap(text, size, 0, size + 1, 0, 0, scratch);
+			assign(scratch, size);
+			return;
+		}
+
+		vector<size_t> cuts(1, 0);
+
+		for(size_t pos = piece; pos < size; pos = max(pos + 1, cuts.back() + piece)){
+			while((pos < size) && (text[pos - 1] != '\n'))
+				pos++;
+
+			if(pos < size)
+				cuts.push_back(pos);
+		}
+
+		cuts.push_back(size);
+		parts.resize(cuts.size() - 1);
+
+		JobSystem::inst().parallel_for(0, parts.size(), 1, [&](size_t from, size_t to){
+			for(size_t i = from; i < to; i++)
+				wrap(text, cuts[i + 1], cuts[i], size + 1, 0, 0, parts[i]);
+		});
+
+		scratch.clear();
+		for(vector<Line> &part : parts)
+			scratch.insert(scratch.end(), part.begin(), part.end());
+
+		assign(scratch, size);
+	}
+
+	// The text in [start, start + old_len) was replaced with new_len
+	// characters. Only lines near the change are wrapped again.
+	template<typename T>
+	void relayout(const T &text, size_t size, size_t start, size_t old_len, size_t new_len){
+		// A space looks ahead to the end of the following word, so wrapping
+		// restarts from the line holding the separator before the edited word.
+		size_t sep = min(start, size);
+
+		while((sep > 0) && (text[sep - 1] != ' ') && (text[sep - 1] != '\n'))
+			sep--;
+
+		size_t count = this->size();
+		size_t first = (count ? line_at(sep ? (sep - 1) : 0) : 0);
+		size_t pos = (count ? (*this)[first].start : 0);
+		long delta = ((long) new_len - (long) old_len);
+
+		// Lines which started inside the old text can't be reused.
+		size_t old_from = first;
+		while((old_from < count) && ((*this)[old_from].start < (start + old_len)))
+			old_from++;
+
+		size_t old = wrap(text, size, pos, start + new_len, old_from, delta, scratch);
+
+		// Drop the lines which were wrapped again. The lines after them are
+		// held from the end of the text, so they're already in place once
+		// the new size is set.
+		move_gap(old);
+		gap_start = first;
+		text_size = size;
+
+		if(scratch.empty())
+			return;
+
+		reserve(scratch.size());
+		memcpy(&buf[gap_start], scratch.data(), sizeof(Line) * scratch.size());
+		gap_start += scratch.size();
+	}
+};
@@ -0,0 +1,129 @@
+/*
+	LogBox
+	mperron (2026)
+
+	A TextBox for long, growing text such as a log. Wrapped lines are kept
+	in a ring of at most max_lines lines, and the oldest are dropped as new
+	ones arrive, so memory stays bounded however much text goes through it.
+	Drawing only touches the lines in view.
+
+	Text is added with append(). Only the text after the last newline is
+	wrapped again on each append, so appending stays cheap as long as the
+	text is broken into lines. If the view is at the bottom, it follows new
+	text as it arrives.
+
+	The width of the box is fixed once text has been added, since the raw
+	text isn't kept to be wrapped again.
+*/
+class LogBox : public TextBox {
+	size_t max_lines;
+	size_t stride;
+
+	// Ring of wrapped lines, each given stride bytes of text: room for a
+	// full line of four byte characters.
+	vector<char> ring_text;
+	vector<uint16_t> ring_len;
+	size_t ring_head = 0, ring_count = 0;
+
+	// Text after the last newline, and the number of lines in the ring
+	// which were wrapped from it.
+	string pending;
+	size_t pending_lines = 0;
+	TextLayout pending_layout;
+
+	void ring_push(const char *text, size_t len){
+		size_t slot;
+
+		if(ring_count < max_lines){
+			slot = ((ring_head + ring_count) % max_lines);
+			ring_count++;
+		} else {
+			// Drop the oldest line, keeping the view on the same text.
+			slot = ring_head;
+			ring_head = ((ring_head + 1) % max_lines);
+
+			if(get_scroll() > 0)
+				set_scroll(get_scroll() - 1);
+		}
+
+		len = min(len, stride);
+		memcpy(&ring_text[slot * stride], text, len);
+		ring_len[slot] = len;
+	}
+
+protected:
+	const char *get_line(size_t n, size_t &len){
+		size_t slot = ((ring_head + n) % max_lines);
+
+		len = ring_len[slot];
+		return &ring_text[slot * stride];
+	}
+
+public:
+	LogBox(SDL_Renderer *rend, SDL_Rect bounds, size_t max_lines = 10000) :
+		TextBox(rend, bounds, ""),
+		max_lines(max(max_lines, (size_t) 1))
+	{
+		pending_layout.chars_perline = chars_perline();
+		stride = ((pending_layout.chars_perline + 1) * 4);
+
+		ring_text.resize(this->max_lines * stride);
+		ring_len.resize(this->max_lines);
+	}
+
+	size_t get_line_count(){
+		return ring_count;
+	}
+
+	void append(const string &text){
+		if(text.empty())
+			return;
+
+		bool at_bottom = ((get_scroll() + get_window_lines()) >= ring_count);
+
+		// Lines wrapped from the unfinished text are wrapped again with the
+		// new text on the end.
+		ring_count -= min(pending_lines, ring_count);
+		pending += text;
+		pending_layout.layout(pending, pending.size());
+
+		for(size_t i = 0; i < pending_layout.size(); i++){
+			TextLayout::Line line = pending_layout[i];
+			ring_push(pending.data() + line.start, line.len);
+		}
+
+		// Lines ending at or before the last newline are finished. Text after
+		// the newline never affects how they are wrapped.
+		size_t nl = pending.rfind('\n');
+		pending_lines = pending_layout.size();
+
+		if(nl != string::npos){
+			for(size_t i = 0; i < pending_layout.size(); i++)
+				if(pending_layout[i].start <= nl)
+					pending_lines--;
+
+			pending.erase(0, nl + 1);
+		}
+
+		layout_changed();
+
+		if(at_bottom)
+			scroll_bottom();
+	}
+
+	void clear(){
+		ring_head = ring_count = 0;
+		pending.clear();
+		pending_lines = 0;
+
+		layout_changed();
+		set_scroll(0);
+	}
+
+	// Scroll so the last line is at the bottom of the box.
+	void scroll_bottom(){
+		size_t window = max(get_window_lines(), 1);
+
+		set_scroll((ring_count > window) ? (ring_count - window) : 0);
+	}
+};
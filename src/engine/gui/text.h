@@ -5,9 +5,12 @@
 	A class which draws text onto the screen using a bitmap font.
 */
 class PicoText :
-	public Drawable
+	public Drawable,
+	public Transformable
 {
-	SDL_Texture *font, *font_shadow;
+	Font *font;
+	SDL_Color color = { 0xff, 0xff, 0xff, 0xff };
+	SDL_Color color_shadow = { 0xff, 0xff, 0xff, 0xff };
 	SDL_Rect region;
 	string message;
 
@@ -21,81 +24,196 @@ class PicoText :
 	// Extra space between lines of text.
 	int leading = 0;
 
+	// Typewriter effect: characters typed out so far.
 	int ticks_perchar = 0;
-	int ticks_passed = 0;
+	size_t chars_typed = 0;
 
 	int shadow_offset_x = 0;
 	int shadow_offset_y = 0;
 
 	unsigned int blink_on = 0;
 	unsigned int blink_off = 0;
+	bool blink_shown = true;
+
+	bool cursor_shown = false;
+
+	// Effects are driven by timers, and cost nothing while they're off.
+	TimerWheel::Timer blink_timer = TimerWheel::NONE;
+	TimerWheel::Timer type_timer = TimerWheel::NONE;
+	TimerWheel::Timer cursor_timer = TimerWheel::NONE;
 
 	size_t scroll_pos = 0;
-	vector<string> message_lines;
+	TextLayout layout;
 	int window_lines = 0;
 
+	// Wrap again after message[start, start + old_len) was replaced by
+	// new_len characters.
+	void relayout(size_t start, size_t old_len, size_t new_len){
+		layout.relayout(message, message.size(), start, old_len, new_len);
+		layout_changed();
+	}
+
 protected:
+	size_t chars_perline(){
+		return ((region.w > c_width) ? ((region.w / c_width) - 1) : 0);
+	}
+
+	// Screen area of the character at col on the row'th line in view.
+	SDL_Rect char_rect(size_t row, size_t col){
+		return (SDL_Rect){
+			(int)(region.x + (col * c_width)),
+			(int)(region.y + (row * (c_height + leading))),
+			c_width, c_height
+		};
+	}
+
+	// The row in view and column under a screen point. Returns false if the
+	// point is outside the text region.
+	bool char_at(int x, int y, size_t &row, size_t &col){
+		if((x < region.x) || (y < region.y) || (x >= (region.x + region.w)) || (y >= (region.y + region.h)))
+			return false;
+
+		row = (y - region.y) / (c_height + leading);
+		col = (x - region.x + (c_width / 2)) / c_width;
+		return true;
+	}
+
+	// The text of wrapped line n, which is len characters long.
+	virtual const char *get_line(size_t n, size_t &len){
+		TextLayout::Line line = layout[n];
+
+		len = line.len;
+		return (message.data() + line.start);
+	}
+
 	virtual void populateLineVector(){
-		stringstream ss;
-		bool wrapped = false;
+		layout.chars_perline = chars_perline();
+		layout.layout(message, message.size());
+		layout_changed();
+	}
 
-		size_t chars_printed = 0;
-		size_t chars_perline = ((region.w > c_width) ? ((region.w / c_width) - 1) : 0);
-		size_t chars_thisline = 0;
+	// Called whenever the lines have been wrapped again.
+	virtual void layout_changed(){
+		// The number of lines of text that fit inside this window.
+		window_lines = region.h / (c_height + leading);
 
-		message_lines.clear();
+		// If we're scrolled past the end of the new message text, this will put
+		// us on the last line.
+		set_scroll(scroll_pos);
+	}
 
-		for(char c : message){
-			chars_printed++;
+	// Show or hide the text for the on or off period, then switch.
+	void blink_step(){
+		blink_timer = TimerWheel::inst().after(blink_shown ? blink_on : blink_off, [this](){
+			blink_shown = !blink_shown;
+			blink_step();
+		});
+	}
 
-			if(wrapped || (c == '\n')){
-				chars_thisline = 0;
-				wrapped = false;
+	// Type out the rest of the message, a character at a time. The timer
+	// stops once the whole message is showing.
+	void typewriter_resume(){
+		TimerWheel &timers = TimerWheel::inst();
 
-				message_lines.push_back(ss.str());
-				ss.str("");
+		if(!ticks_perchar || timers.pending(type_timer) || (chars_typed > message.size()))
+			return;
 
-				// If the text just wrapped at the edge of the text region, skip a
-				// following space which would be at the start of the line and look
-				// bad, and a following newline which would otherwise result in a
-				// double newline.
-				if((c == '\n') || (c == ' '))
-					continue;
-			}
+		type_timer = timers.every(ticks_perchar, [this](){
+			if(++chars_typed > message.size())
+				TimerWheel::inst().cancel_clear(type_timer);
+		});
+	}
 
-			ss << c;
-			chars_thisline++;
+	// Start or stop blinking the cursor to match draw_cursor.
+	void cursor_check(){
+		TimerWheel &timers = TimerWheel::inst();
 
-			// Automatically wrap at the edge of the text region.
-			if(chars_thisline > chars_perline)
-				wrapped = true;
+		if(draw_cursor == timers.pending(cursor_timer))
+			return;
 
-			// Wrap if a word won't fit unless the word is really big.
-			if(!wrapped && (c == ' ') && (chars_thisline > (chars_perline / 2))){
-				size_t next_space_pos = message.find_first_of(" \n", chars_printed);
+		if(draw_cursor)
+			cursor_step();
+		else
+			timers.cancel_clear(cursor_timer);
+	}
+	void cursor_step(){
+		cursor_timer = TimerWheel::inst().after(cursor_shown ? 300 : 200, [this](){
+			cursor_shown = !cursor_shown;
+			cursor_step();
+		});
+	}
 
-				if(next_space_pos == string::npos)
-					next_space_pos = (message.size() - 1);
+	// Returns false while the text is blinked off. chars_max is the number
+	// of characters to show.
+	bool effects_state(size_t &chars_max){
+		// Skip draw if we are in the off period.
+		if(!blink_shown)
+			return false;
 
-				if((next_space_pos - chars_printed + chars_thisline) > chars_perline)
-					wrapped = true;
-			}
-		}
+		chars_max = -1;
+		if(ticks_perchar && (chars_typed <= message.size()))
+			chars_max = chars_typed;
 
-		// Last line.
-		{
-			string final = ss.str();
+		return true;
+	}
+
+	// Pass each visible glyph and where it goes to out(), stopping after
+	// chars_max characters. dst is left where the next character would go.
+	// Returns false if the text was cut short.
+	template<typename F>
+	bool each_glyph(size_t chars_max, SDL_Rect &dst, F out){
+		size_t chars_printed = 0;
+		int printed_lines = 0;
 
-			if(final.size())
-				message_lines.push_back(final);
+		dst = (SDL_Rect){
+			region.x, region.y - (c_height + leading),
+			c_width, c_height
+		};
+
+		for(size_t n = scroll_pos, count = get_line_count(); n < count; n++){
+			size_t len;
+			const char *l = get_line(n, len);
+
+			// New line
+			dst.x = region.x;
+			dst.y += (c_height + leading);
+
+			for(size_t i = 0; i < len;){
+				// Break early for the typewriter effect.
+				if(chars_printed++ > chars_max)
+					return false;
+
+				const Font::Glyph &glyph = font->glyph_utf8(l, len, i);
+				SDL_Rect at = { dst.x, dst.y, glyph.src.w, glyph.src.h };
+
+				out(glyph, at);
+				dst.x += glyph.advance;
+			}
+
+			// Can't fit any more text in this box.
+			if(++printed_lines >= window_lines)
+				break;
 		}
 
-		// The number of lines of text that fit inside this window.
-		window_lines = region.h / (c_height + leading);
+		return true;
+	}
 
-		// If we're scrolled past the end of the new message text, this will put
-		// us on the last line.
-		set_scroll(scroll_pos);
+	// Draw the cursor at dst while it's blinked on, into the queue if there
+	// is one.
+	void cursor_draw(const SDL_Rect &dst, RenderQueue *queue){
+		if(cursor_shown){
+			SDL_Rect cursor = (SDL_Rect){
+				dst.x, dst.y + c_height - 3,
+				c_width - 1, 2
+			};
+
+			if(queue){
+				queue->outline(cursor, (SDL_Color){ 0, 0xff, 0, 0xff });
+			} else {
+				SDL_SetRenderDrawColor(rend, 0, 0xff, 0, 0xff);
+				SDL_RenderDrawRect(rend, &cursor);
+			}
+		}
 	}
 
 public:
@@ -105,19 +223,23 @@ public:
 	bool draw_cursor = false;
 
 	PicoText(SDL_Renderer *rend, SDL_Rect region, string message) :
-		Drawable(rend)
+		Drawable(rend),
+		Transformable(region.x, region.y)
 	{
-		this->region = region;
-		set_message(message);
-
 		// Load the default font image.
-		font = textureFromBmp(rend, "fonts/6x7.bmp", true);
-		font_shadow = textureFromBmp(rend, "fonts/6x7.bmp", true);
+		font = FontAtlas::get(rend)->font("fonts/6x7.bmp", c_width, c_height);
+
+		this->region = region;
+		this->message = message;
+		populateLineVector();
 	}
 
-	~PicoText(){
-		SDL_DestroyTexture(font);
-		SDL_DestroyTexture(font_shadow);
+	virtual ~PicoText(){
+		TimerWheel &timers = TimerWheel::inst();
+
+		timers.cancel(blink_timer);
+		timers.cancel(type_timer);
+		timers.cancel(cursor_timer);
 	}
 
 	void set_shadow(int x, int y){
@@ -126,21 +248,24 @@ public:
 	}
 
 	void set_font(string bitmap, int c_width, int c_height){
-		SDL_DestroyTexture(font);
-		SDL_DestroyTexture(font_shadow);
-
-		font = textureFromBmp(rend, bitmap.c_str(), true);
-		font_shadow = textureFromBmp(rend, bitmap.c_str(), true);
+		set_font(FontAtlas::get(rend)->font(bitmap, c_width, c_height));
+	}
+	void set_font(Font *font){
+		this->font = font;
+		c_width = font->c_width;
+		c_height = font->c_height;
 
-		this->c_width = c_width;
-		this->c_height = c_height;
+		populateLineVector();
+	}
+	Font *get_font(){
+		return font;
 	}
 
 	size_t get_scroll(){
 		return scroll_pos;
 	}
 	void set_scroll(size_t pos){
-		scroll_pos = min(pos, message_lines.size() - 1);
+		scroll_pos = min(pos, get_line_count() - 1);
 	}
 	void set_scroll_offset(int offset){
 		if((offset < 0) && ((size_t)(offset * -1) > scroll_pos))
@@ -148,13 +273,11 @@ public:
 		else
 			scroll_pos += offset;
 
-		if(scroll_pos > message_lines.size() - 1)
-			scroll_pos = message_lines.size() - 1;
+		if(scroll_pos > get_line_count() - 1)
+			scroll_pos = get_line_count() - 1;
 	}
 
 	void draw(int ticks){
-		static unsigned int blink_counter = 0;
-
 		// Text frame for debug purposes.
 		if(draw_frame){
 			SDL_RenderDrawLine(rend, region.x, region.y, region.x + region.w, region.y);
@@ -163,137 +286,166 @@ public:
 			SDL_RenderDrawLine(rend, region.x + region.w, region.y + region.h, region.x + region.w, region.y);
 		}
 
-		// Blink text.
-		if(blink_on || blink_off){
-			blink_counter += ticks;
+		cursor_check();
 
-			// Skip draw if we are beyond the on period.
-			if((blink_counter % (blink_on + blink_off)) > blink_on)
-				return;
+		size_t chars_max;
+		if(!effects_state(chars_max))
+			return;
 
-			// Keep the blink_counter from growing indefinitely.
-			while(blink_counter > (blink_on + blink_off))
-				blink_counter -= (blink_on + blink_off);
-		}
+		SDL_Texture *tx = font->texture();
+		SDL_Rect dst;
 
-		SDL_Rect src = (SDL_Rect){
-			0,0,
-			c_width, c_height
-		};
-		SDL_Rect dst = (SDL_Rect){
-			region.x, region.y - (c_height + leading),
-			c_width, c_height
-		};
-		bool shadow = (shadow_offset_x || shadow_offset_y);
+		// Shadows go first, so they fall behind all of the text.
+		if(shadow_offset_x || shadow_offset_y){
+			SDL_SetTextureColorMod(tx, color_shadow.r, color_shadow.g, color_shadow.b);
+			SDL_SetTextureAlphaMod(tx, color_shadow.a);
 
-		size_t chars_printed = 0;
-		size_t chars_max = -1;
-		if(ticks_perchar){
-			unsigned int chars = ((ticks_passed + ticks) / ticks_perchar);
-
-			// We don't want chars_max or ticks_passed to count up
-			// indefinitely. Cap these values as soon as we're beyond the
-			// length of the string.
-			if(chars <= message.size()){
-				ticks_passed += ticks;
-				chars_max = chars;
-			}
+			each_glyph(chars_max, dst, [&](const Font::Glyph &glyph, SDL_Rect &at){
+				at.x += shadow_offset_x;
+				at.y += shadow_offset_y;
+
+				SDL_RenderCopy(rend, tx, &glyph.src, &at);
+			});
 		}
 
-		size_t scroll = 0;
-		int printed_lines = 0;
-		for(string l : message_lines){
-			if(scroll++ < scroll_pos)
-				continue;
+		SDL_SetTextureColorMod(tx, color.r, color.g, color.b);
+		SDL_SetTextureAlphaMod(tx, color.a);
 
-			// New line
-			dst.x = region.x - c_width;
-			dst.y += (c_height + leading);
+		bool complete = each_glyph(chars_max, dst, [&](const Font::Glyph &glyph, SDL_Rect &at){
+			SDL_RenderCopy(rend, tx, &glyph.src, &at);
+		});
 
-			for(char c : l){
-				dst.x += c_width;
+		if(!complete){
+			// Show a little caret character at the end of the current line.
+			if(pointer_char)
+				SDL_RenderCopy(rend, tx, &font->glyph(pointer_char).src, &dst);
 
-				// Break early for the typewriter effect.
-				if((chars_max >= 0) && (chars_printed++ > chars_max)){
-					// Show a little caret character at the end of the current line.
-					if(pointer_char){
-						src.x = (pointer_char - ' ') * c_width;
-						SDL_RenderCopy(rend, font, &src, &dst);
-					}
-
-					return;
-				}
+			return;
+		}
 
-				if((c >= 'a') && (c <= 'z'))
-					c -= 0x20;
+		// Draw a blinking cursor.
+		if(draw_cursor)
+			cursor_draw(dst, NULL);
+	}
 
-				// The font starts at space.
-				c -= ' ';
+	// Glyphs are queued as copies from the font atlas, so text sharing a
+	// batch is drawn together. Shadows go in the first pass, the text in
+	// the next and the cursor over both.
+	void submit(RenderQueue &queue, int ticks){
+		queue.set_depth(draw_layer, draw_z);
 
-				// Unknown characters print a space.
-				if(c >= 65)
-					c = 0;
+		if(draw_frame)
+			queue.outline(region, (SDL_Color){ 0xff, 0xff, 0xff, 0xff });
 
-				src.x = (c * c_width);
+		cursor_check();
 
-				if(shadow){
-					SDL_Rect dst_shadow = (SDL_Rect){
-						dst.x + shadow_offset_x, dst.y + shadow_offset_y,
-						dst.w, dst.h
-					};
+		size_t chars_max;
+		if(!effects_state(chars_max))
+			return;
 
-					SDL_RenderCopy(rend, font_shadow, &src, &dst_shadow);
-				}
+		SDL_Texture *tx = font->texture();
+		SDL_Rect dst;
+		bool shadow = (shadow_offset_x || shadow_offset_y);
 
-				SDL_RenderCopy(rend, font, &src, &dst);
-			}
+		if(shadow){
+			each_glyph(chars_max, dst, [&](const Font::Glyph &glyph, SDL_Rect &at){
+				at.x += shadow_offset_x;
+				at.y += shadow_offset_y;
 
-			// Can't fit any more text in this box.
-			if(++printed_lines >= window_lines)
-				break;
+				queue.copy(tx, &glyph.src, at, color_shadow);
+			});
 		}
 
-		// Draw a blinking cursor.
-		if(draw_cursor){
-			static bool displaycursor = false;
-			static int tickcounter = 0;
-
-			tickcounter += ticks;
+		queue.set_pass(1);
 
-			if(tickcounter > (displaycursor ? 300 : 200)){
-				displaycursor = !displaycursor;
-				tickcounter = 0;
-			}
+		bool complete = each_glyph(chars_max, dst, [&](const Font::Glyph &glyph, SDL_Rect &at){
+			queue.copy(tx, &glyph.src, at, color);
+		});
 
-			if(displaycursor){
-				SDL_Rect cursor = (SDL_Rect){
-					dst.x + c_width, dst.y + c_height - 3,
-					c_width - 1, 2
-				};
+		if(!complete){
+			if(pointer_char)
+				queue.copy(tx, &font->glyph(pointer_char).src, dst, color);
 
-				SDL_SetRenderDrawColor(rend, 0, 0xff, 0, 0xff);
-				SDL_RenderDrawRect(rend, &cursor);
-			}
+			return;
 		}
 
+		queue.set_pass(2);
+
+		if(draw_cursor)
+			cursor_draw(dst, &queue);
+	}
+
+	bool submits_commands(){
+		return true;
 	}
 
 	string get_message(){ return message; }
-	void set_message(string message){
+	void set_message(const string &message){
+		size_t size_old = this->message.size(), size_new = message.size();
+		size_t prefix = 0, suffix = 0;
+
+		// Only the part which changed needs to be wrapped again.
+		while((prefix < size_old) && (prefix < size_new) && (this->message[prefix] == message[prefix]))
+			prefix++;
+
+		while(((suffix + prefix) < size_old) && ((suffix + prefix) < size_new) && (this->message[size_old - suffix - 1] == message[size_new - suffix - 1]))
+			suffix++;
+
 		this->message = message;
-		populateLineVector();
-		ticks_passed = 0;
+
+		// Start typing again from the beginning.
+		TimerWheel::inst().cancel_clear(type_timer);
+		chars_typed = 0;
+		typewriter_resume();
+
+		if((prefix != size_old) || (prefix != size_new))
+			relayout(prefix, size_old - prefix - suffix, size_new - prefix - suffix);
+	}
+
+	// Add text to the end of the message. Only the last line is wrapped again.
+	virtual void append(const string &text){
+		size_t size_old = message.size();
+
+		message += text;
+		relayout(size_old, 0, text.size());
+
+		typewriter_resume();
+	}
+
+	// Replace the number starting at pos in the message with value, e.g. to
+	// update a counter. A number of the same width is overwritten in place,
+	// and can't change the wrapping, so nothing is laid out again.
+	void set_number(long value, size_t pos = 0){
+		char digits[24];
+		size_t len = 0;
+		size_t len_new = snprintf(digits, sizeof(digits), "%ld", value);
+
+		pos = min(pos, message.size());
+
+		while(((pos + len) < message.size()) && (isdigit((unsigned char) message[pos + len]) || (!len && (message[pos] == '-'))))
+			len++;
+
+		if(len == len_new){
+			memcpy(&message[pos], digits, len);
+		} else {
+			message.replace(pos, len, digits, len_new);
+			relayout(pos, len, len_new);
+		}
 	}
 
 	// The number of lines of text after wrapping.
-	size_t get_line_count(){ return message_lines.size(); }
+	virtual size_t get_line_count(){ return layout.size(); }
 
 	// The number of lines of text that will fit in the window.
 	int get_window_lines(){ return window_lines; }
 
 	// Set the color of the text at any time.
 	virtual void set_color(char r, char g, char b, bool shadow = false){
-		SDL_SetTextureColorMod((shadow ? font_shadow : font), r, g, b);
+		SDL_Color &c = (shadow ? color_shadow : color);
+
+		c.r = r;
+		c.g = g;
+		c.b = b;
 	}
 	void set_color(SDL_Color col, bool shadow = false){
 		set_color(col.r, col.g, col.b, shadow);
@@ -301,24 +453,37 @@ public:
 
 	// Set the alpha/transparency for the text at any time.
 	void set_alpha(char a, bool shadow = false){
-		SDL_SetTextureAlphaMod((shadow ? font_shadow : font), a);
+		(shadow ? color_shadow : color).a = a;
 	}
 
 	void set_blink(unsigned int on, unsigned int off){
 		blink_on = on;
 		blink_off = off;
+		blink_shown = true;
+
+		TimerWheel::inst().cancel_clear(blink_timer);
+
+		if(on || off)
+			blink_step();
 	}
 
 	// Set the number of millisecond ticks to hang on each character when
 	// simulating a typewriter. Set to 0 (default) to disable this effect.
 	void set_ticks_perchar(int ticks){
 		ticks_perchar = ticks;
-		ticks_passed = 0;
+		chars_typed = 0;
+
+		TimerWheel::inst().cancel_clear(type_timer);
+		typewriter_resume();
 	}
 
+	// Relative to the parent element, if there is one.
 	void set_pos(int x, int y){
-		region.x = x;
-		region.y = y;
+		transform_set_local(x, y);
+	}
+	virtual void on_transform(int world_x, int world_y){
+		region.x = world_x;
+		region.y = world_y;
 	}
 	void set_size(int w, int h){
 		region.w = w;
@@ -409,8 +574,9 @@ class TextBox : public PicoText, public Clickable {
 		return m_bounds.y + SCROLL_ARROW_HEIGHT + 1 + (int)((m_sb_height_max - m_sb_height) * get_scroll_ratio());
 	}
 
-	virtual void populateLineVector(){
-		PicoText::populateLineVector();
+protected:
+	virtual void layout_changed(){
+		PicoText::layout_changed();
 
 		// Calculate size of scroll bar.
 		m_sb_height_max = m_bounds.h - (2 * SCROLL_ARROW_HEIGHT) - 2;
@@ -439,6 +605,14 @@ public:
 
 	~TextBox(){}
 
+	virtual void on_transform(int world_x, int world_y){
+		PicoText::on_transform(world_x, world_y);
+
+		m_bounds.x = world_x;
+		m_bounds.y = world_y;
+		set_click_region(m_bounds);
+	}
+
 	virtual void check_mouse(SDL_Event event){
 		Clickable::check_mouse(event);
 
@@ -519,6 +693,16 @@ public:
 		sb_g = g;
 		sb_b = b;
 	}
+	// The scroll bar is drawn directly, so the whole box is drawn at its
+	// place in the queue.
+	void submit(RenderQueue &queue, int ticks){
+		Drawable::submit(queue, ticks);
+	}
+
+	bool submits_commands(){
+		return false;
+	}
+
 	void set_color_hl(char r, char g, char b){
 		sb_r_hl = r;
 		sb_g_hl = g;
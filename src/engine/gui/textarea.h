@@ -0,0 +1,453 @@
+/*
+	GapBuffer, TextArea
+	mperron (2026)
+
+	An editable, multi-line text box. Text is kept in a gap buffer: the
+	unused space sits at the cursor, so typing and deleting there only
+	moves the gap and never the rest of the text. After each edit only the
+	lines around it are wrapped again, so the cost of a keystroke doesn't
+	grow with the size of the document.
+
+	The text area takes typed text from SDL_TEXTINPUT events once it has
+	been clicked on, or activated with set_active(). Arrow keys, home and
+	end move the cursor, with shift to select, and ctrl+a/c/x/v select all
+	and use the clipboard.
+*/
+class GapBuffer {
+	vector<char> buf;
+	size_t gap_start = 0, gap_end = 0;
+
+	void move_gap(size_t pos){
+		if(pos < gap_start){
+			size_t n = (gap_start - pos);
+
+			memmove(&buf[gap_end - n], &buf[pos], n);
+			gap_start -= n;
+			gap_end -= n;
+		} else if(pos > gap_start){
+			size_t n = (pos - gap_start);
+
+			memmove(&buf[gap_start], &buf[gap_end], n);
+			gap_start += n;
+			gap_end += n;
+		}
+	}
+
+	void reserve(size_t n){
+		if((gap_end - gap_start) >= n)
+			return;
+
+		size_t tail = (buf.size() - gap_end);
+		size_t capacity = max(buf.size() * 2, size() + n + 64);
+
+		buf.resize(capacity);
+		memmove(&buf[capacity - tail], &buf[gap_end], tail);
+		gap_end = (capacity - tail);
+	}
+
+public:
+	size_t size() const {
+		return (buf.size() - (gap_end - gap_start));
+	}
+
+	char operator[](size_t i) const {
+		return ((i < gap_start) ? buf[i] : buf[i + (gap_end - gap_start)]);
+	}
+
+	void insert(size_t pos, const char *text, size_t n){
+		if(!n)
+			return;
+
+		reserve(n);
+		move_gap(pos);
+
+		memcpy(&buf[gap_start], text, n);
+		gap_start += n;
+	}
+
+	void erase(size_t pos, size_t n){
+		move_gap(pos);
+		gap_end += min(n, buf.size() - gap_end);
+	}
+
+	string substr(size_t pos, size_t n) const {
+		string out;
+
+		n = min(n, size() - min(pos, size()));
+		out.reserve(n);
+
+		for(size_t i = pos; i < (pos + n); i++)
+			out += (*this)[i];
+
+		return out;
+	}
+
+	// n characters at pos, as contiguous text. Text which spans the gap is
+	// copied into scratch.
+	const char *span(size_t pos, size_t n, string &scratch) const {
+		if((pos + n) <= gap_start)
+			return &buf[pos];
+
+		if(pos >= gap_start)
+			return &buf[pos + (gap_end - gap_start)];
+
+		scratch = substr(pos, n);
+		return scratch.data();
+	}
+};
+
+class TextArea : public TextBox, public Typable {
+	GapBuffer text;
+	TextLayout area_layout;
+	string line_scratch;
+
+	// The cursor, and the other end of the selection.
+	size_t cursor = 0, anchor = 0;
+
+	// Column the cursor tries to stay in when moving up and down.
+	size_t column_want = 0;
+
+	// The cursor blinks while the text area is active.
+	bool cursor_on = false;
+	TimerWheel::Timer blink_timer = TimerWheel::NONE;
+
+	// Show the cursor, and start its blink over.
+	void blink_restart(){
+		TimerWheel::inst().cancel_clear(blink_timer);
+		cursor_on = true;
+
+		if(m_typing_active)
+			blink_step();
+	}
+	void blink_step(){
+		blink_timer = TimerWheel::inst().after(cursor_on ? 600 : 400, [this](){
+			cursor_on = !cursor_on;
+			blink_step();
+		});
+	}
+
+	size_t cursor_row(){
+		return (area_layout.size() ? area_layout.line_at(cursor) : 0);
+	}
+	size_t cursor_col(){
+		if(area_layout.empty())
+			return 0;
+
+		return area_layout.column(text, cursor_row(), cursor);
+	}
+
+	// Position of column col on line row, within the line. Columns count
+	// characters, not bytes.
+	size_t line_pos(size_t row, size_t col){
+		if(area_layout.empty())
+			return 0;
+
+		return area_layout.position(text, min(row, area_layout.size() - 1), col);
+	}
+
+	// UTF-8 continuation bytes belong to the character before them.
+	bool continuation(size_t pos){
+		return ((pos < text.size()) && ((text[pos] & 0xc0) == 0x80));
+	}
+
+	// Start of the character at pos, and of the ones before and after it.
+	size_t char_start(size_t pos){
+		pos = min(pos, text.size());
+
+		while((pos > 0) && continuation(pos))
+			pos--;
+
+		return pos;
+	}
+	size_t char_prev(size_t pos){
+		return ((pos > 0) ? char_start(pos - 1) : 0);
+	}
+	size_t char_next(size_t pos){
+		if(pos < text.size())
+			pos++;
+
+		while(continuation(pos))
+			pos++;
+
+		return pos;
+	}
+
+	void move_cursor(size_t pos, bool select){
+		cursor = char_start(pos);
+
+		if(!select)
+			anchor = cursor;
+
+		blink_restart();
+		scroll_to_cursor();
+	}
+
+	void scroll_to_cursor(){
+		size_t row = cursor_row();
+		size_t window = max(get_window_lines(), 1);
+
+		if(row < get_scroll())
+			set_scroll(row);
+		else if(row >= (get_scroll() + window))
+			set_scroll(row - window + 1);
+	}
+
+	// Replace the selection with n characters, and wrap again around them.
+	void replace(const char *insert, size_t n){
+		size_t start = min(cursor, anchor);
+		size_t len = (max(cursor, anchor) - start);
+
+		if(len)
+			text.erase(start, len);
+		if(n)
+			text.insert(start, insert, n);
+
+		area_layout.relayout(text, text.size(), start, len, n);
+		layout_changed();
+
+		move_cursor(start + n, false);
+		column_want = cursor_col();
+	}
+
+	void copy_selection(){
+		size_t start = min(cursor, anchor);
+
+		if(cursor != anchor)
+			SDL_SetClipboardText(text.substr(start, max(cursor, anchor) - start).c_str());
+	}
+
+protected:
+	const char *get_line(size_t n, size_t &len){
+		TextLayout::Line line = area_layout[n];
+
+		len = line.len;
+		return text.span(line.start, line.len, line_scratch);
+	}
+
+	void populateLineVector(){
+		PicoText::populateLineVector();
+
+		area_layout.chars_perline = chars_perline();
+		area_layout.layout(text, text.size());
+		layout_changed();
+	}
+
+public:
+	TextArea(SDL_Renderer *rend, SDL_Rect bounds, string message = "") :
+		TextBox(rend, bounds, ""),
+		Typable(false)
+	{
+		area_layout.chars_perline = chars_perline();
+		set_text(message);
+	}
+
+	~TextArea(){
+		TimerWheel::inst().cancel(blink_timer);
+	}
+
+	size_t get_line_count(){
+		return area_layout.size();
+	}
+
+	string get_text(){
+		return text.substr(0, text.size());
+	}
+	void set_text(const string &message){
+		text.erase(0, text.size());
+		text.insert(0, message.data(), message.size());
+
+		area_layout.layout(text, text.size());
+		layout_changed();
+
+		cursor = anchor = column_want = 0;
+		set_scroll(0);
+	}
+
+	size_t get_cursor(){ return cursor; }
+	void set_cursor(size_t pos){ move_cursor(pos, false); }
+
+	// The selected text runs from start for len characters.
+	void get_selection(size_t &start, size_t &len){
+		start = min(cursor, anchor);
+		len = (max(cursor, anchor) - start);
+	}
+	void set_selection(size_t start, size_t len){
+		anchor = char_start(start);
+		move_cursor(start + len, true);
+	}
+
+	void set_active(bool active){
+		m_typing_active = active;
+		blink_restart();
+	}
+	bool get_active(){
+		return m_typing_active;
+	}
+
+	// Insert text at the cursor, replacing any selection.
+	void insert(const string &s){
+		replace(s.data(), s.size());
+	}
+
+	void textinput(SDL_TextInputEvent event){
+		if(m_typing_active)
+			replace(event.text, strlen(event.text));
+	}
+
+	void keydown(SDL_KeyboardEvent event){
+		if(!m_typing_active)
+			return;
+
+		bool select = (event.keysym.mod & KMOD_SHIFT);
+		bool ctrl = (event.keysym.mod & KMOD_CTRL);
+		size_t row = cursor_row();
+
+		switch(event.keysym.sym){
+			case SDLK_LEFT:
+				if((cursor != anchor) && !select)
+					move_cursor(min(cursor, anchor), false);
+				else if(cursor > 0)
+					move_cursor(char_prev(cursor), select);
+
+				column_want = cursor_col();
+				break;
+
+			case SDLK_RIGHT:
+				if((cursor != anchor) && !select)
+					move_cursor(max(cursor, anchor), false);
+				else
+					move_cursor(char_next(cursor), select);
+
+				column_want = cursor_col();
+				break;
+
+			case SDLK_UP:
+				if(row > 0)
+					move_cursor(line_pos(row - 1, column_want), select);
+				else
+					move_cursor(0, select);
+				break;
+
+			case SDLK_DOWN:
+				if((row + 1) < area_layout.size())
+					move_cursor(line_pos(row + 1, column_want), select);
+				else
+					move_cursor(text.size(), select);
+				break;
+
+			case SDLK_HOME:
+				move_cursor(line_pos(row, 0), select);
+				column_want = 0;
+				break;
+
+			case SDLK_END:
+				move_cursor(line_pos(row, -1), select);
+				column_want = cursor_col();
+				break;
+
+			case SDLK_BACKSPACE:
+				if((cursor == anchor) && (cursor > 0))
+					anchor = char_prev(cursor);
+
+				replace(NULL, 0);
+				break;
+
+			case SDLK_DELETE:
+				if(cursor == anchor)
+					anchor = char_next(cursor);
+
+				replace(NULL, 0);
+				break;
+
+			case SDLK_RETURN:
+			case SDLK_KP_ENTER:
+				replace("\n", 1);
+				break;
+
+			case SDLK_a:
+				if(ctrl){
+					anchor = 0;
+					move_cursor(text.size(), true);
+				}
+				break;
+
+			case SDLK_c:
+				if(ctrl)
+					copy_selection();
+				break;
+
+			case SDLK_x:
+				if(ctrl){
+					copy_selection();
+					replace(NULL, 0);
+				}
+				break;
+
+			case SDLK_v:
+				if(ctrl && SDL_HasClipboardText()){
+					char *clip = SDL_GetClipboardText();
+
+					replace(clip, strlen(clip));
+					SDL_free(clip);
+				}
+				break;
+		}
+	}
+
+	virtual void on_mouse_down(SDL_MouseButtonEvent event){
+		TextBox::on_mouse_down(event);
+
+		size_t row, col;
+
+		// Clicking in the text places the cursor there.
+		if(char_at(event.x, event.y, row, col)){
+			set_active(true);
+			move_cursor(line_pos(get_scroll() + row, col), false);
+			column_want = col;
+		}
+	}
+
+	void draw(int ticks){
+		size_t window = max(get_window_lines(), 1);
+		size_t first = get_scroll();
+		size_t last = min(first + window, area_layout.size());
+
+		// Selection highlight.
+		if(cursor != anchor){
+			size_t sel_start = min(cursor, anchor), sel_end = max(cursor, anchor);
+
+			SDL_SetRenderDrawColor(rend, 0x60, 0x80, 0xf0, 0x80);
+
+			for(size_t n = first; n < last; n++){
+				TextLayout::Line line = area_layout[n];
+				size_t a = max(sel_start, line.start), b = min(sel_end, line.start + line.len);
+
+				if(a >= b)
+					continue;
+
+				SDL_Rect from = char_rect(n - first, area_layout.column(text, n, a));
+				SDL_Rect to = char_rect(n - first, area_layout.column(text, n, b));
+
+				from.w = (to.x - from.x);
+				SDL_RenderFillRect(rend, &from);
+			}
+		}
+
+		TextBox::draw(ticks);
+
+		// Blinking cursor.
+		if(m_typing_active){
+			size_t row = cursor_row();
+
+			if(cursor_on && (row >= first) && (row < (first + window))){
+				SDL_Rect at = char_rect(row - first, cursor_col());
+
+				at.x -= 1;
+				at.w = 1;
+
+				SDL_SetRenderDrawColor(rend, 0xff, 0xff, 0xff, 0xff);
+				SDL_RenderFillRect(rend, &at);
+			}
+		}
+	}
+};
@@ -0,0 +1,226 @@
+/*
+	HitchDetector, HitchZone
+	mperron (2026)
+
+	Notes down what was going on during frames which take too long, so
+	that stutters players see can be tracked down afterwards.
+
+	Through each frame the detector keeps a few counters: assets read from
+	disk or decoded, textures created through create_texture() and events
+	handled, along with the time spent in each profiling zone. A HitchZone marks a zone for as long as it's in scope:
+
+		{
+			HitchZone zone("physics");
+			...
+		}
+
+	Zone names must be string literals, or otherwise outlive the program.
+	Only zones on the main thread are counted.
+
+	At the end of a frame, if it took longer than the threshold, a line is
+	appended to hitches.log in the save path with the scene, the counters,
+	and the zones by time spent. Otherwise the counters are just cleared,
+	so the detector costs almost nothing while frames are on time. When
+	frames are slow one after another, only a few are written each second
+	and the rest are counted in the next line.
+*/
+string get_save_path();
+
+class HitchDetector {
+	friend class HitchZone;
+
+	static const int ZONES = 16;
+	static const int DEPTH = 16;
+
+	struct Zone {
+		const char *name;
+		uint64_t us;
+	};
+
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t frame_start = 0;
+	uint64_t frame_count = 0;
+
+	// Time in each zone this frame, and the zones open now.
+	Zone zones[ZONES];
+	int zones_used = 0;
+	const char *open[DEPTH];
+	int depth = 0;
+
+	// First asset loaded on the main thread this frame.
+	string asset_first;
+
+	FILE *log = NULL;
+	uint32_t written_at = 0;
+	int skipped = 0;
+
+	HitchDetector(){}
+
+	void zone_enter(const char *name){
+		if(depth < DEPTH)
+			open[depth] = name;
+
+		depth++;
+	}
+
+	void zone_exit(const char *name, uint64_t us){
+		depth--;
+
+		for(int i = 0; i < zones_used; i++){
+			if(zones[i].name == name){
+				zones[i].us += us;
+				return;
+			}
+		}
+
+		if(zones_used < ZONES)
+			zones[zones_used++] = (Zone){ name, us };
+	}
+
+	void write(uint64_t us, const string &scene){
+		if(!log){
+			log = fopen((get_save_path() + "hitches.log").c_str(), "a");
+
+			if(!log){
+				// Nowhere to write, so stop looking.
+				cerr << "Cannot open hitch log." << endl;
+				threshold_us = 0;
+				return;
+			}
+		}
+
+		sort(zones, zones + zones_used, [](const Zone &a, const Zone &b){
+			return (a.us > b.us);
+		});
+
+		fprintf(log, "%lld frame %llu: %llu us, scene %s, loads %u, textures %u, events %u (motion %u, keys %u)",
+			(long long) time(NULL), (unsigned long long) frame_count, (unsigned long long) us,
+			(scene.size() ? scene.c_str() : "-"),
+			loads.load(), textures, events, events_motion, events_keys
+		);
+
+		if(asset_first.size())
+			fprintf(log, ", first load %s", asset_first.c_str());
+
+		if(zones_used){
+			fprintf(log, ", zones");
+
+			for(int i = 0; i < zones_used; i++)
+				fprintf(log, " %s=%llu", zones[i].name, (unsigned long long) zones[i].us);
+		}
+
+		if(depth){
+			fprintf(log, ", open");
+
+			for(int i = 0; i < min(depth, (int) DEPTH); i++)
+				fprintf(log, " %s", open[i]);
+		}
+
+		if(skipped)
+			fprintf(log, ", %d more not logged", skipped);
+
+		fprintf(log, "\n");
+		fflush(log);
+
+		skipped = 0;
+	}
+
+public:
+	// Frames longer than this are logged. Zero turns the detector off.
+	uint64_t threshold_us = 50000;
+
+	// Most lines to write each second.
+	int rate_max = 4;
+
+	// Counts for the current frame. Assets may be loaded from any thread.
+	atomic<uint32_t> loads{0};
+	uint32_t textures = 0;
+	uint32_t events = 0, events_motion = 0, events_keys = 0;
+
+	static HitchDetector &inst(){
+		static HitchDetector *detector = new HitchDetector();
+		return *detector;
+	}
+
+	// SDL_CreateTexture() and SDL_CreateTextureFromSurface(), counting the
+	// texture for this frame. The engine creates its textures through these.
+	static SDL_Texture *create_texture(SDL_Renderer *rend, Uint32 format, int access, int w, int h){
+		inst().textures++;
+		return SDL_CreateTexture(rend, format, access, w, h);
+	}
+	static SDL_Texture *create_texture(SDL_Renderer *rend, SDL_Surface *sf){
+		inst().textures++;
+		return SDL_CreateTextureFromSurface(rend, sf);
+	}
+
+	// An asset was read or decoded. Finding one already loaded isn't
+	// counted.
+	void load(const string &fname){
+		loads++;
+
+		if(asset_first.empty() && MainQueue::inst().is_main())
+			asset_first = fname;
+	}
+
+	void event(const SDL_Event &event){
+		events++;
+
+		if(event.type == SDL_MOUSEMOTION)
+			events_motion++;
+		else if((event.type == SDL_KEYDOWN) || (event.type == SDL_KEYUP))
+			events_keys++;
+	}
+
+	// Call as the frame's work begins, after any wait for it to be due.
+	void frame_begin(){
+		frame_start = SDL_GetPerformanceCounter();
+	}
+
+	// Call as the frame's work ends, before waiting for the next.
+	void frame_end(const string &scene){
+		frame_count++;
+
+		if(threshold_us && frame_start){
+			uint64_t us = FrameClock::to_us(SDL_GetPerformanceCounter() - frame_start, freq);
+
+			if(us > threshold_us){
+				uint32_t now = SDL_GetTicks();
+
+				if((now - written_at) >= (uint32_t)(1000 / max(1, rate_max))){
+					write(us, scene);
+					written_at = now;
+				} else {
+					skipped++;
+				}
+			}
+		}
+
+		zones_used = 0;
+		asset_first.clear();
+		loads = 0;
+		textures = events = events_motion = events_keys = 0;
+	}
+};
+
+class HitchZone {
+	const char *name;
+	uint64_t start;
+
+public:
+	HitchZone(const char *name) :
+		name(MainQueue::inst().is_main() ? name : NULL),
+		start(0)
+	{
+		if(this->name){
+			HitchDetector::inst().zone_enter(name);
+			start = SDL_GetPerformanceCounter();
+		}
+	}
+
+	~HitchZone(){
+		if(name){
+			HitchDetector &hd = HitchDetector::inst();
+			hd.zone_exit(name, FrameClock::to_us(SDL_GetPerformanceCounter() - start, hd.freq));
+		}
+	}
+};
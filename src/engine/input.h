@@ -0,0 +1,226 @@
+/*
+	InputSnapshot, InputState
+	mperron (2026)
+
+	Keyboard state, kept as bit arrays indexed by scancode, so asking about
+	a key is a single bit test and nothing is allocated.
+
+	InputState follows key events as they arrive. Before each update step,
+	the controller publishes an InputSnapshot: which keys are held, and
+	which were pressed or released since the last one. A key pressed and
+	let go in between shows as both. Each press or release is seen by
+	exactly one step: when a frame runs several steps, only the first sees
+	the frame's edges, and the rest just see which keys are held. Frames
+	which run no update steps don't publish, so their presses and releases
+	carry over to the next step rather than being lost. The previous
+	step's snapshot is kept too.
+
+	Keys can be bound to named actions, so game code can ask for "jump"
+	rather than a particular key. Each action has its own bit in the
+	snapshot, worked out when it's published, so asking about an action
+	costs the same as asking about a key. An action is held while any of
+	its keys are held. There are at most 64 actions.
+
+	Queries by SDL keycode, as taken by Controller::keystate(), are turned
+	into scancodes for the current keyboard layout.
+*/
+class InputSnapshot {
+	friend class InputState;
+
+	static const int WORDS = ((SDL_NUM_SCANCODES + 63) / 64);
+
+	uint64_t keys_down[WORDS] = {};
+	uint64_t keys_pressed[WORDS] = {};
+	uint64_t keys_released[WORDS] = {};
+
+	uint64_t actions_down = 0, actions_pressed = 0, actions_released = 0;
+
+	static bool test(const uint64_t *bits, SDL_Scancode sc){
+		return ((unsigned) sc < SDL_NUM_SCANCODES) && ((bits[sc >> 6] >> (sc & 63)) & 1);
+	}
+	static bool test(uint64_t bits, int action){
+		return ((unsigned) action < 64) && ((bits >> action) & 1);
+	}
+
+public:
+	bool down(SDL_Scancode sc) const {
+		return test(keys_down, sc);
+	}
+	bool pressed(SDL_Scancode sc) const {
+		return test(keys_pressed, sc);
+	}
+	bool released(SDL_Scancode sc) const {
+		return test(keys_released, sc);
+	}
+
+	bool action_down(int action) const {
+		return test(actions_down, action);
+	}
+	bool action_pressed(int action) const {
+		return test(actions_pressed, action);
+	}
+	bool action_released(int action) const {
+		return test(actions_released, action);
+	}
+};
+
+class InputState {
+	static const int WORDS = InputSnapshot::WORDS;
+
+	// Keys held now, and edges since the last snapshot.
+	InputSnapshot live;
+
+	InputSnapshot current, previous;
+
+	// Actions by name, and the keys bound to each.
+	map<string, int> actions;
+	vector<pair<SDL_Scancode, int>> binds;
+
+	// Scancodes for ASCII keycodes in the current layout, or -1 if not yet
+	// looked up.
+	int16_t ascii[128];
+
+	static void set(uint64_t *bits, SDL_Scancode sc, bool on){
+		if(on)
+			bits[sc >> 6] |= ((uint64_t) 1 << (sc & 63));
+		else
+			bits[sc >> 6] &= ~((uint64_t) 1 << (sc & 63));
+	}
+
+	void ascii_clear(){
+		for(int i = 0; i < 128; i++)
+			ascii[i] = -1;
+	}
+
+public:
+	InputState(){
+		ascii_clear();
+	}
+
+	// Follow a key or keymap event.
+	void event(const SDL_Event &event){
+		switch(event.type){
+			case SDL_KEYDOWN:
+			case SDL_KEYUP:
+			{
+				SDL_Scancode sc = event.key.keysym.scancode;
+				bool down = (event.type == SDL_KEYDOWN);
+
+				if((unsigned) sc >= SDL_NUM_SCANCODES)
+					break;
+
+				if((event.key.keysym.sym >= 0) && (event.key.keysym.sym < 128))
+					ascii[event.key.keysym.sym] = sc;
+
+				// Repeats aren't new presses.
+				if(down != InputSnapshot::test(live.keys_down, sc))
+					set(down ? live.keys_pressed : live.keys_released, sc, true);
+
+				set(live.keys_down, sc, down);
+				break;
+			}
+
+			case SDL_KEYMAPCHANGED:
+				ascii_clear();
+				break;
+		}
+	}
+
+	// Publish a snapshot of the keys, with the edges since the last one.
+	// Call before each update step, after the frame's events.
+	void publish(){
+		previous = current;
+		current = live;
+
+		for(int i = 0; i < WORDS; i++)
+			live.keys_pressed[i] = live.keys_released[i] = 0;
+
+		uint64_t released = 0;
+		current.actions_down = current.actions_pressed = 0;
+
+		for(auto &bind : binds){
+			uint64_t bit = ((uint64_t) 1 << bind.second);
+
+			if(current.down(bind.first))
+				current.actions_down |= bit;
+			if(current.pressed(bind.first))
+				current.actions_pressed |= bit;
+			if(current.released(bind.first))
+				released |= bit;
+		}
+
+		// Let go of one key while holding another, and the action is still
+		// held.
+		current.actions_released = (released & ~current.actions_down);
+	}
+
+	// Input for this update step, and for the one before it.
+	const InputSnapshot &get() const {
+		return current;
+	}
+	const InputSnapshot &get_previous() const {
+		return previous;
+	}
+
+	// Whether a key is held right now, between snapshots.
+	bool down(SDL_Scancode sc) const {
+		return live.down(sc);
+	}
+	bool down_key(SDL_Keycode key){
+		return live.down(scancode(key));
+	}
+
+	// The scancode of a keycode in the current layout.
+	SDL_Scancode scancode(SDL_Keycode key){
+		if(key & SDLK_SCANCODE_MASK)
+			return (SDL_Scancode)(key & ~SDLK_SCANCODE_MASK);
+
+		if((key >= 0) && (key < 128)){
+			if(ascii[key] < 0)
+				ascii[key] = SDL_GetScancodeFromKey(key);
+
+			return (SDL_Scancode) ascii[key];
+		}
+
+		return SDL_GetScancodeFromKey(key);
+	}
+
+	// The number for an action, which is added if it's new. Returns -1 if
+	// there are already 64.
+	int action(const string &name){
+		auto it = actions.find(name);
+
+		if(it != actions.end())
+			return it->second;
+
+		if(actions.size() >= 64)
+			return -1;
+
+		int id = actions.size();
+		actions[name] = id;
+
+		return id;
+	}
+
+	// Bind a key to an action. An action may have any number of keys.
+	int bind(const string &name, SDL_Scancode sc){
+		int id = action(name);
+
+		if(id >= 0)
+			binds.push_back(make_pair(sc, id));
+
+		return id;
+	}
+
+	void unbind(const string &name){
+		auto it = actions.find(name);
+
+		if(it == actions.end())
+			return;
+
+		int id = it->second;
+		binds.erase(remove_if(binds.begin(), binds.end(), [id](const pair<SDL_Scancode, int> &bind){
+			return (bind.second == id);
+		}), binds.end());
+	}
+};
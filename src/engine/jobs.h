@@ -0,0 +1,364 @@
+/*
+	JobCounter, JobSystem
+	mperron (2026)
+
+	A fixed pool of worker threads for spreading work across cores. Jobs
+	are small functions. Each thread, including the main thread, has its own
+	queue: a thread takes its newest job first, and when its queue runs dry
+	it steals the oldest job from another, so busy threads are rarely
+	interrupted and the work evens itself out.
+
+	A JobCounter tracks a group of jobs. Waiting on a counter doesn't block
+	the thread; it runs queued jobs until the group is done. The main
+	thread only runs jobs of the group it's waiting on, so it isn't held up
+	by unrelated work, such as a job waiting on something posted to the
+	MainQueue. Jobs can also be held back until a counter reaches zero
+	with run_after(), which chains work without waiting at all.
+
+	parallel_for() splits a range into chunks and runs them across the pool,
+	returning once they're all done. With no workers, as on the web, every
+	job simply runs on the calling thread.
+
+	Each thread keeps count of the time it spends running jobs, so report()
+	shows how well work is spreading across the pool.
+*/
+class JobCounter {
+	friend class JobSystem;
+
+	atomic<int> pending{0};
+
+	// Jobs waiting for this counter to reach zero.
+	mutex lock;
+	vector<pair<function<void()>, JobCounter*>> after;
+
+public:
+	bool done(){
+		return !pending.load();
+	}
+};
+
+class JobSystem {
+	struct Job {
+		function<void()> fn;
+		JobCounter *counter;
+	};
+
+	struct Queue {
+		mutex lock;
+		deque<Job> jobs;
+
+		// Time spent running jobs, and how many were run and stolen.
+		atomic<uint64_t> busy_us{0};
+		atomic<uint64_t> jobs_run{0};
+		atomic<uint64_t> steals{0};
+	};
+
+	// Queue 0 belongs to the main thread, and the rest to the workers.
+	vector<Queue*> queues;
+	vector<thread> workers;
+	atomic<bool> running{false};
+
+	// Jobs in all queues, for idle workers to sleep on.
+	atomic<int> queued{0};
+	mutex sleep_lock;
+	condition_variable sleep_cond;
+
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t stats_from = SDL_GetPerformanceCounter();
+
+	static int &thread_index(){
+		static thread_local int index = 0;
+		return index;
+	}
+
+	JobSystem(){
+#ifdef __EMSCRIPTEN__
+		start(0);
+#else
+		start(max(0, (int) thread::hardware_concurrency() - 1));
+#endif
+	}
+
+	void push(Job job){
+		Queue *q = queues[min((size_t) thread_index(), queues.size() - 1)];
+
+		{
+			lock_guard<mutex> guard(q->lock);
+			q->jobs.push_back(job);
+		}
+
+		queued++;
+
+		// Taking the lock orders this against a worker about to sleep.
+		{ lock_guard<mutex> guard(sleep_lock); }
+		sleep_cond.notify_one();
+	}
+
+	// Queue a job, or run it here if there are no workers to run it.
+	void dispatch(Job job){
+		if(queues.size() > 1){
+			push(job);
+			return;
+		}
+
+		execute(0, job);
+	}
+
+	// Take a job, newest first from our own queue, or else oldest first
+	// from another thread's.
+	bool take(int index, Job &job){
+		Queue *own = queues[index];
+
+		{
+			lock_guard<mutex> guard(own->lock);
+
+			if(own->jobs.size()){
+				job = own->jobs.back();
+				own->jobs.pop_back();
+				queued--;
+				return true;
+			}
+		}
+
+		for(size_t i = 1; i < queues.size(); i++){
+			Queue *q = queues[(index + i) % queues.size()];
+			lock_guard<mutex> guard(q->lock);
+
+			if(q->jobs.size()){
+				job = q->jobs.front();
+				q->jobs.pop_front();
+				queued--;
+				own->steals++;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Take a job of the counter's group from any queue, newest first from
+	// our own.
+	bool take_for(int index, JobCounter *counter, Job &job){
+		for(size_t i = 0; i < queues.size(); i++){
+			Queue *q = queues[(index + i) % queues.size()];
+			lock_guard<mutex> guard(q->lock);
+
+			for(size_t j = 0; j < q->jobs.size(); j++){
+				size_t at = (i ? j : (q->jobs.size() - 1 - j));
+
+				if(q->jobs[at].counter != counter)
+					continue;
+
+				job = q->jobs[at];
+				q->jobs.erase(q->jobs.begin() + at);
+				queued--;
+
+				if(i)
+					queues[index]->steals++;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void execute(int index, Job &job){
+		uint64_t start = SDL_GetPerformanceCounter();
+		job.fn();
+
+		Queue *q = queues[index];
+		q->busy_us += ((SDL_GetPerformanceCounter() - start) * 1000000 / freq);
+		q->jobs_run++;
+
+		if(job.counter)
+			finish(job.counter);
+	}
+
+	// One job of the counter's group is done. Release any jobs waiting for
+	// the group once it's empty.
+	// The count only drops with the lock held, so a waiter which sees it
+	// reach zero can take the lock to know the counter is no longer in use.
+	void finish(JobCounter *counter){
+		vector<pair<function<void()>, JobCounter*>> ready;
+
+		{
+			lock_guard<mutex> guard(counter->lock);
+
+			if(--counter->pending)
+				return;
+
+			ready.swap(counter->after);
+		}
+
+		for(auto &it : ready)
+			dispatch((Job){ it.first, it.second });
+	}
+
+	void worker_main(int index){
+		thread_index() = index;
+
+		while(running){
+			Job job;
+
+			if(take(index, job)){
+				execute(index, job);
+				continue;
+			}
+
+			unique_lock<mutex> lock(sleep_lock);
+			sleep_cond.wait(lock, [this]{
+				return (!running || (queued > 0));
+			});
+		}
+	}
+
+public:
+	static JobSystem &inst(){
+		static JobSystem *system = new JobSystem();
+		return *system;
+	}
+
+	// Number of threads sharing work, including the main thread.
+	int threads(){
+		return (int) queues.size();
+	}
+
+	// Restart the pool with a number of worker threads, besides the main
+	// thread. Jobs still queued are run first.
+	void start(int count){
+		stop();
+
+		for(int i = 0; i <= count; i++)
+			queues.push_back(new Queue());
+
+		running = true;
+
+		for(int i = 1; i <= count; i++)
+			workers.push_back(thread(&JobSystem::worker_main, this, i));
+
+		stats_reset();
+	}
+
+	void stop(){
+		running = false;
+		{ lock_guard<mutex> guard(sleep_lock); }
+		sleep_cond.notify_all();
+
+		for(thread &worker : workers)
+			worker.join();
+
+		workers.clear();
+
+		// Anything left over runs here.
+		Job job;
+		while(queues.size() && take(0, job))
+			execute(0, job);
+
+		for(Queue *q : queues)
+			delete q;
+
+		queues.clear();
+	}
+
+	// Queue fn to run on any thread. If counter is given, it counts the job
+	// until it has run.
+	void run(function<void()> fn, JobCounter *counter = NULL){
+		if(counter)
+			counter->pending++;
+
+		dispatch((Job){ fn, counter });
+	}
+
+	// Queue fn once dependency reaches zero, without waiting for it.
+	void run_after(JobCounter &dependency, function<void()> fn, JobCounter *counter = NULL){
+		if(counter)
+			counter->pending++;
+
+		{
+			lock_guard<mutex> guard(dependency.lock);
+
+			if(dependency.pending){
+				dependency.after.push_back(make_pair(fn, counter));
+				return;
+			}
+		}
+
+		dispatch((Job){ fn, counter });
+	}
+
+	// Run queued jobs until the counter's group is done. The main thread
+	// only runs jobs of the group.
+	void wait(JobCounter &counter){
+		int index = min(thread_index(), (int) queues.size() - 1);
+
+		while(counter.pending){
+			Job job;
+
+			if(index ? take(index, job) : take_for(index, &counter, job))
+				execute(index, job);
+			else
+				this_thread::yield();
+		}
+
+		lock_guard<mutex> guard(counter.lock);
+	}
+
+	// Call f(from, to) over chunks of [begin, end) of up to grain items,
+	// spread across the pool. A grain of 0 picks one to give each thread a
+	// few chunks.
+	template<typename F>
+	void parallel_for(size_t begin, size_t end, size_t grain, F f){
+		if(end <= begin)
+			return;
+
+		size_t n = (end - begin);
+
+		if(!grain)
+			grain = max((size_t) 1, n / (queues.size() * 4));
+
+		if((queues.size() <= 1) || (n <= grain)){
+			f(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+
+		for(size_t from = begin; from < end; from += grain){
+			size_t to = min(end, from + grain);
+
+			run([&f, from, to](){
+				f(from, to);
+			}, &counter);
+		}
+
+		wait(counter);
+	}
+
+	void stats_reset(){
+		for(Queue *q : queues){
+			q->busy_us = 0;
+			q->jobs_run = 0;
+			q->steals = 0;
+		}
+
+		stats_from = SDL_GetPerformanceCounter();
+	}
+
+	// Print each thread's share of the time since the stats were reset
+	// spent running jobs.
+	void report(){
+		uint64_t elapsed_us = max((uint64_t) 1, (SDL_GetPerformanceCounter() - stats_from) * 1000000 / freq);
+
+		cout << "Jobs: " << queues.size() << " threads over " << (elapsed_us / 1000) << " ms" << endl;
+
+		for(size_t i = 0; i < queues.size(); i++){
+			Queue *q = queues[i];
+
+			cout << "  " << (i ? ("worker " + to_string(i)) : string("main")) << ": "
+				<< (q->busy_us * 100 / elapsed_us) << "% busy, "
+				<< q->jobs_run << " jobs, "
+				<< q->steals << " stolen" << endl;
+		}
+	}
+};
@@ -32,8 +32,10 @@ public:
 
 	// Get a surface for this asset if it's an image.
 	SDL_Surface *surface(){
-		if(!sf)
+		if(!sf){
+			HitchDetector::inst().load(fname);
 			sf = SDL_LoadBMP_RW(rwops(), 0);
+		}
 
 		return this->sf;
 	}
@@ -46,15 +48,19 @@ public:
 	}
 
 	Mix_Music *music(){
-		if(!mu)
+		if(!mu){
+			HitchDetector::inst().load(fname);
 			mu = Mix_LoadMUS_RW(rwops(), 0);
+		}
 
 		return mu;
 	}
 
 	Mix_Chunk *sound(){
-		if(!snd)
+		if(!snd){
+			HitchDetector::inst().load(fname);
 			snd = Mix_LoadWAV_RW(rwops(), 0);
+		}
 
 		return snd;
 	}
@@ -63,6 +69,11 @@ public:
 		return data_raw;
 	}
 
+	// Size of the decoded data in bytes.
+	size_t size(){
+		return size_raw;
+	}
+
 	void write_to_disk(){
 		std::filesystem::path path_out(get_save_path() + fname);
 
@@ -106,6 +117,8 @@ FileLoader *FileLoader::get(string fname){
 		FILE *infile = fopen(path_in.string().c_str(), "r");
 
 		if(infile){
+			HitchDetector::inst().load(fname);
+
 			// Get file size.
 			fseek(infile, 0L, SEEK_END);
 			size_t fsize = ftell(infile);
@@ -129,9 +142,17 @@ FileLoader *FileLoader::get(string fname){
 
 // Turn the base64 encoded data into real data.
 void FileLoader::decode_all(){
-	for(auto x : assets){
-		FileLoader *fl = x.second;
+	vector<FileLoader*> files;
 
-		fl->data_raw = base64_dec(fl->data.c_str(), strlen(fl->data.c_str()));
-	}
+	for(auto x : assets)
+		files.push_back(x.second);
+
+	// Each file decodes independently, so they're spread across threads.
+	JobSystem::inst().parallel_for(0, files.size(), 1, [&files](size_t from, size_t to){
+		for(size_t i = from; i < to; i++){
+			FileLoader *fl = files[i];
+
+			fl->data_raw = base64_dec(fl->data.c_str(), strlen(fl->data.c_str()));
+		}
+	});
 }
@@ -10,11 +10,21 @@
 #include <unordered_map>
 #include <string>
 #include <sstream>
+#include <iomanip>
 #include <list>
 #include <cmath>
 #include <vector>
 #include <regex>
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <chrono>
 
 #define SCREEN_WIDTH  384
 #define SCREEN_HEIGHT 216
@@ -22,24 +32,59 @@
 
 using namespace std;
 
+#include "dispatch.h"
+#include "jobs.h"
+#include "clock.h"
+#include "hitch.h"
 #include "loader.h"
 #include "utility.h"
+#include "timer.h"
+#include "quality.h"
+#include "input.h"
+
+#include "render/queue.h"
+#include "render/config.h"
+
+#include "world/grid.h"
 
 #include "ables/drawable.h"
 #include "ables/movable.h"
 #include "ables/clickable.h"
 #include "ables/typable.h"
+#include "ables/transformable.h"
 
 #include "gui/cardpanel.h"
+#include "gui/font.h"
+#include "gui/layout.h"
 #include "gui/text.h"
+#include "gui/logbox.h"
+#include "gui/textarea.h"
 #include "gui/button.h"
 
+#include "world/camera.h"
+
+#include "render/transition.h"
+#include "render/canvas.h"
+#include "render/recorder.h"
+#include "render/indexed.h"
+#include "render/sprite.h"
+
+// Post-processing and lighting.
+#include "fx/post.h"
+#include "fx/light.h"
+
 #include "scene.h"
 
 // Particle effects.
 #include "fx/particle.h"
 #include "fx/snow.h"
 
+// World.
+#include "world/tilemap.h"
+
+// Engine benchmarks.
+#include "bench/__bench.h"
+
 // Game code.
 #include "game/__game.h"
 
@@ -56,24 +101,87 @@ using namespace std;
 #ifndef GAME_VERSION
  #define GAME_VERSION string("v0.01")
 #endif
+#ifndef GAME_RENDERER_BENCHMARK
+ // Benchmark the render drivers on first launch.
+ #define GAME_RENDERER_BENCHMARK false
+#endif
 
 string get_save_path(){
 	static char *pref_path = SDL_GetPrefPath(GAME_AUTHOR, GAME_SAVEPATH);
 	return pref_path;
 }
 
+// Time from an input event arriving to the first frame showing its effect
+// being presented.
+struct LatencyMeter {
+	bool enabled = false;
+
+	uint64_t freq = SDL_GetPerformanceFrequency();
+	uint64_t input_at = 0, drawn_at = 0;
+
+	uint64_t sum_us = 0, max_us = 0;
+	int samples = 0;
+	uint32_t report_at = 0;
+
+	// Note the oldest input event not yet drawn. Event timestamps are in
+	// SDL ticks, so they're converted to the performance counter.
+	void input(const SDL_Event &event){
+		uint64_t now = SDL_GetPerformanceCounter();
+		uint32_t age = SDL_GetTicks() - event.common.timestamp;
+		uint64_t at = now - min(now, (uint64_t) age * freq / 1000);
+
+		if(!input_at || (at < input_at))
+			input_at = at;
+	}
+
+	// The scene has been drawn with all input so far.
+	void drawn(){
+		if(input_at && !drawn_at){
+			drawn_at = input_at;
+			input_at = 0;
+		}
+	}
+
+	void presented(){
+		if(!drawn_at)
+			return;
+
+		uint64_t us = (SDL_GetPerformanceCounter() - drawn_at) * 1000000 / freq;
+		drawn_at = 0;
+
+		sum_us += us;
+		max_us = max(max_us, us);
+		samples++;
+
+		// Report every five seconds.
+		uint32_t now = SDL_GetTicks();
+		if(enabled && (now >= report_at)){
+			cout << "Input latency: avg " << (sum_us / samples) << " us, max " << max_us << " us (" << samples << " samples)" << endl;
+
+			sum_us = max_us = 0;
+			samples = 0;
+			report_at = now + 5000;
+		}
+	}
+};
+
 struct EngineContext {
 	bool run;
 	SDL_Window *pWin;
 	SDL_Renderer *pRend;
-	map<int, bool> *pKeys;
+	InputState *pInput;
 	Scene::Controller *pCtrl;
 
-	int ticks_last;
+	FrameClock clock;
 
-	EngineContext() :
+	// Sample input as late as possible, and present the frame drawn from
+	// it straight away, instead of one frame later.
+	bool low_latency = false;
+	LatencyMeter latency;
+
+	EngineContext(string scene_first, RendererConfig &renderer, bool renderer_bench) :
 		run(true),
-		pKeys(new map<int, bool>())
+		pInput(new InputState())
 	{
 		// Automatically set default value based on desktop resolution.
 		int render_scale = 5;
@@ -94,15 +202,28 @@ struct EngineContext {
 		}
 
 		pWin = SDL_CreateWindow(GAME_NAME, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, (SCREEN_WIDTH * render_scale), (SCREEN_HEIGHT * render_scale), SDL_WINDOW_SHOWN);
-		pRend = SDL_CreateRenderer(pWin, -1, 0);
+
+		if(renderer_bench){
+			renderer.benchmark(pWin);
+			renderer.save();
+		}
+		pRend = renderer.create(pWin);
 
 		SDL_SetRenderDrawBlendMode(pRend, SDL_BLENDMODE_BLEND);
 		SDL_RenderSetLogicalSize(pRend, SCREEN_WIDTH, SCREEN_HEIGHT);
 
 		// Create controller and load the first scene.
-		pCtrl = new Scene::Controller(pWin, pRend, render_scale, render_scale_max, pKeys);
+		pCtrl = new Scene::Controller(pWin, pRend, render_scale, render_scale_max, pInput);
 		registerScenes(pCtrl);
-		pCtrl->set_scene(Scene::create(pCtrl, "intro"));
+
+		// Benchmarks are only there to be found when one was asked for.
+		if(!scene_first.compare(0, 6, "bench/"))
+			registerBenchScenes();
+		Scene *scene = Scene::create(pCtrl, scene_first);
+		if(!scene)
+			cerr << "No scene named \"" << scene_first << "\"." << endl;
+
+		pCtrl->set_scene(scene);
 
 		//pCtrl->set_volume(preferences->data->volume);
 
@@ -111,84 +232,209 @@ struct EngineContext {
 			pCtrl->fullscreen = true;
 		}*/
 
-		ticks_last = SDL_GetTicks();
+		clock.reset();
+	}
+
+	~EngineContext(){
+		delete pCtrl;
+		delete pInput;
+
+		RendererConfig::destroy(pRend);
+		SDL_DestroyWindow(pWin);
 	}
 };
 
+// Step the current scene and draw it. The time this takes is what the
+// quality governor holds to the frame budget.
+static void step_and_draw(EngineContext *pCtx, int ticks){
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	{
+		HitchZone zone("update");
+		pCtx->pCtrl->update(pCtx->clock.delta_us);
+	}
+	{
+		HitchZone zone("draw");
+		pCtx->pCtrl->draw(ticks);
+	}
+	pCtx->latency.drawn();
+
+	uint64_t us = FrameClock::to_us(SDL_GetPerformanceCounter() - start, SDL_GetPerformanceFrequency());
+	QualityGovernor::inst().frame(us, pCtx->pCtrl->pacer.period_us());
+}
+
+static void present(EngineContext *pCtx){
+	HitchZone zone("present");
+
+	SDL_RenderPresent(pCtx->pRend);
+	pCtx->latency.presented();
+}
+
 static void gameloop(void *pCtxVoid){
 	EngineContext *pCtx = (EngineContext*) pCtxVoid;
 
 	while(pCtx->run){
-		int ticks_now = SDL_GetTicks();
-		const int ticks = ticks_now - pCtx->ticks_last;
-		SDL_Event event;
+		// Wait for the next frame before sampling input, so that input is as
+		// fresh as possible when the frame is drawn.
+		if(pCtx->low_latency)
+			pCtx->pCtrl->pacer.wait();
+
+		const int ticks = pCtx->clock.tick();
+		pCtx->pCtrl->frame_us = pCtx->clock.delta_us;
+		HitchDetector::inst().frame_begin();
+
+		{
+			HitchZone zone("events");
+			SDL_Event event;
+
+			// Check for an event without waiting.
+			while(SDL_PollEvent(&event)){
+				HitchDetector::inst().event(event);
 
-		// Check for an event without waiting.
-		while(SDL_PollEvent(&event)){
-			switch(event.type){
+				switch(event.type){
 #ifndef __EMSCRIPTEN__
-				case SDL_QUIT:
-					pCtx->run = false;
-					break;
+					case SDL_QUIT:
+						pCtx->run = false;
+						break;
 #endif
 
-				// Map out keystates
-				case SDL_KEYUP:
-					(*(pCtx->pKeys))[event.key.keysym.sym] = false;
-					break;
-				case SDL_KEYDOWN:
-					(*(pCtx->pKeys))[event.key.keysym.sym] = true;
-					pCtx->pCtrl->keydown(event.key);
-					break;
-
-				case SDL_MOUSEMOTION:
-				case SDL_MOUSEBUTTONDOWN:
-				case SDL_MOUSEBUTTONUP:
-				case SDL_MOUSEWHEEL:
-				case SDL_FINGERDOWN:
-				case SDL_FINGERUP:
-					pCtx->pCtrl->check_mouse(event);
-					break;
-
-				case SDL_WINDOWEVENT:
-					// Handle window sub-events.
-					switch(event.window.event){
-						case SDL_WINDOWEVENT_FOCUS_LOST:
-							// Disable fullscreen if we lose focus, because SDL doesn't handle it well.
-							if(pCtx->pCtrl->fullscreen){
-								SDL_SetWindowFullscreen(pCtx->pCtrl->win, 0);
-								pCtx->pCtrl->fullscreen = false;
-							}
-							break;
-					}
-					break;
+					// Map out keystates
+					case SDL_KEYUP:
+					case SDL_KEYMAPCHANGED:
+						pCtx->pInput->event(event);
+						break;
+					case SDL_KEYDOWN:
+						pCtx->pInput->event(event);
+						pCtx->pCtrl->keydown(event.key);
+						pCtx->latency.input(event);
+						break;
+					case SDL_TEXTINPUT:
+						pCtx->pCtrl->textinput(event.text);
+						pCtx->latency.input(event);
+						break;
+
+					case SDL_MOUSEMOTION:
+					case SDL_MOUSEBUTTONDOWN:
+					case SDL_MOUSEBUTTONUP:
+					case SDL_MOUSEWHEEL:
+					case SDL_FINGERDOWN:
+					case SDL_FINGERUP:
+						pCtx->pCtrl->check_mouse(event);
+						pCtx->latency.input(event);
+						break;
+
+					case SDL_WINDOWEVENT:
+						// Handle window sub-events.
+						switch(event.window.event){
+							case SDL_WINDOWEVENT_FOCUS_LOST:
+								// Disable fullscreen if we lose focus, because SDL doesn't handle it well.
+								if(pCtx->pCtrl->fullscreen){
+									SDL_SetWindowFullscreen(pCtx->pCtrl->win, 0);
+									pCtx->pCtrl->fullscreen = false;
+								}
+								break;
+						}
+						break;
+				}
 			}
+
+			// Motion this frame goes to the scene as one event.
+			pCtx->pCtrl->mouse_flush();
 		}
 
-		// Draw cursor and flip to display this frame.
-		pCtx->pCtrl->draw_cursor();
-		SDL_RenderPresent(pCtx->pRend);
+		// Run work handed back from other threads, within its time budget.
+		{
+			HitchZone zone("main queue");
+			MainQueue::inst().drain();
+		}
 
-		// Draw the current scene.
-		pCtx->pCtrl->draw(ticks);
+		if(pCtx->low_latency){
+			// Draw the current scene, then the cursor, and flip to display it.
+			step_and_draw(pCtx, ticks);
 
-		// Delay to limit to approximately SCREEN_FPS.
-		{
-			int frame_time = SDL_GetTicks() - ticks_now;
-			int delta = (1000 / SCREEN_FPS) - frame_time - 1;
+			pCtx->pCtrl->draw_cursor();
+			present(pCtx);
+		} else {
+			// Draw cursor and flip to display this frame.
+			pCtx->pCtrl->draw_cursor();
+			present(pCtx);
 
-			if(delta > 0)
-				SDL_Delay(delta);
+			// Step the current scene and draw it.
+			step_and_draw(pCtx, ticks);
 		}
 
-		// Update tick counter.
-		pCtx->ticks_last = ticks_now;
+		// Log the frame if it ran long.
+		Scene *scene = pCtx->pCtrl->scene;
+		HitchDetector::inst().frame_end(scene ? scene->get_name() : string());
+
+		if(pCtx->pCtrl->quitting()){
+			pCtx->run = false;
+			break;
+		}
+
+		// Wait for the next frame.
+		if(!pCtx->low_latency)
+			pCtx->pCtrl->pacer.wait();
 	}
 }
 
 int main(int argc, char **argv){
+	// Work posted back from other threads runs on this one.
+	MainQueue::inst();
+
 #include "assetblob"
 
+	// The first scene is "intro" unless a benchmark was requested.
+	string scene_first = "intro";
+
+	// Renderer overrides, which are saved for next time.
+	string renderer_driver;
+	bool renderer_vsync = false, renderer_novsync = false;
+	bool renderer_bench = false;
+
+	bool low_latency = false, cursor_hardware = false, latency_report = false;
+	bool pacing_report = false, jobs_report = false;
+	int fps = SCREEN_FPS;
+	int jobs = -1;
+	int quality = -1;
+	bool quality_report = false;
+	int hitch_ms = -1;
+
+	for(int i = 1; i < argc; i++){
+		string arg = argv[i];
+
+		if((arg == "--bench") && ((i + 1) < argc))
+			scene_first = string("bench/") + argv[++i];
+		else if((arg == "--renderer") && ((i + 1) < argc))
+			renderer_driver = argv[++i];
+		else if(arg == "--vsync")
+			renderer_vsync = true;
+		else if(arg == "--no-vsync")
+			renderer_novsync = true;
+		else if(arg == "--renderer-bench")
+			renderer_bench = true;
+		else if(arg == "--low-latency")
+			low_latency = true;
+		else if(arg == "--hw-cursor")
+			cursor_hardware = true;
+		else if(arg == "--latency")
+			latency_report = true;
+		else if((arg == "--fps") && ((i + 1) < argc))
+			fps = atoi(argv[++i]);
+		else if(arg == "--pacing")
+			pacing_report = true;
+		else if((arg == "--jobs") && ((i + 1) < argc))
+			jobs = atoi(argv[++i]);
+		else if(arg == "--job-stats")
+			jobs_report = true;
+		else if((arg == "--quality") && ((i + 1) < argc))
+			quality = atoi(argv[++i]);
+		else if(arg == "--quality-report")
+			quality_report = true;
+		else if((arg == "--hitch-ms") && ((i + 1) < argc))
+			hitch_ms = atoi(argv[++i]);
+	}
+
 	// Load preferences (might override render_scale or volume setting).
 	// TODO
 	//PersistenceHandler *preferences = PersistenceHandler::inst();
@@ -205,13 +451,55 @@ int main(int argc, char **argv){
 		return -2;
 	}
 
-	EngineContext *pCtx = new EngineContext();
+	// Renderer settings from the last run, or a benchmark on first launch.
+	RendererConfig renderer;
+	if(!renderer.load() && GAME_RENDERER_BENCHMARK)
+		renderer_bench = true;
+
+	if(renderer_driver.size() || renderer_vsync || renderer_novsync){
+		if(renderer_driver.size())
+			renderer.driver = renderer_driver;
+		if(renderer_vsync || renderer_novsync)
+			renderer.vsync = renderer_vsync;
+
+		renderer.save();
+	}
+
+	// Worker threads besides the main thread.
+	if(jobs >= 0)
+		JobSystem::inst().start(jobs);
+
+	EngineContext *pCtx = new EngineContext(scene_first, renderer, renderer_bench);
+	pCtx->low_latency = low_latency;
+	pCtx->latency.enabled = latency_report;
+	pCtx->pCtrl->set_cursor_hardware(cursor_hardware);
+	pCtx->pCtrl->pacer.set_rate(fps);
+	pCtx->pCtrl->pacer.report = pacing_report;
+
+	// Benchmarks run at full quality unless told otherwise, so that their
+	// results are comparable.
+	if((quality < 0) && !scene_first.compare(0, 6, "bench/"))
+		quality = QualityGovernor::TIER_MAX;
+
+	QualityGovernor::inst().pin(quality);
+	QualityGovernor::inst().report = quality_report;
+
+	// Frames over this long are logged. Zero turns logging off.
+	if(hitch_ms >= 0)
+		HitchDetector::inst().threshold_us = ((uint64_t) hitch_ms * 1000);
 
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop_arg(gameloop, (void*) pCtx, 0, 1);
 #else
 	while(pCtx->run) { gameloop(pCtx); }
 
+	if(jobs_report)
+		JobSystem::inst().report();
+
+	// Scenes may still have jobs of their own to wait for.
+	delete pCtx;
+	JobSystem::inst().stop();
+
 	// Clean up and close SDL library.
 	Mix_CloseAudio();
 	SDL_Quit();
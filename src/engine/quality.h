@@ -0,0 +1,184 @@
+/*
+	QualityGovernor
+	mperron (2026)
+
+	Trades detail for frame rate on machines which can't keep up. The time
+	each frame spends updating and drawing is kept over a rolling window,
+	and a high percentile of it is checked against the frame budget set by
+	the pacer. Going over budget steps the quality tier down; staying well
+	under it for a while steps it back up.
+
+	The thresholds are far apart and stepping up takes much longer than
+	stepping down, so the tier doesn't flap between two levels. If a step
+	up is soon followed by a step down, the next step up waits twice as
+	long.
+
+	Subsystems subscribe to hear the tier, and decide for themselves what
+	to give up at each one: particle effects thin out, expensive post
+	passes switch off, and the tile map bakes chunks more lazily.
+*/
+class QualityGovernor {
+public:
+	static const int TIER_MIN = 0;
+	static const int TIER_MAX = 3;
+
+	typedef int Subscription;
+	static const Subscription NONE = -1;
+
+private:
+	// Frames in the rolling window, and how often it's checked.
+	static const int WINDOW = 120;
+	static const int CHECK_EVERY = 30;
+
+	// Checks in a row needed to step down, and at first to step up.
+	static const int DOWN_CHECKS = 2;
+	static const int UP_CHECKS = 16;
+	static const int UP_CHECKS_MAX = 128;
+
+	uint64_t samples[WINDOW];
+	int sample_next = 0, sample_count = 0;
+	int frames_to_check = CHECK_EVERY;
+
+	int tier = TIER_MAX;
+	int pinned = -1;
+
+	int over = 0, under = 0;
+	int up_checks = UP_CHECKS;
+
+	// Checks since the tier last stepped up, to spot a step up which didn't
+	// hold.
+	int since_up = -1;
+
+	// Percentile of the window at the last check.
+	uint64_t measured_us = 0;
+
+	map<Subscription, function<void(int)>> subscribers;
+	Subscription subscriber_next = 0;
+
+	QualityGovernor(){}
+
+	void set_tier(int t, uint64_t budget_us){
+		if(t < TIER_MIN)
+			t = TIER_MIN;
+		if(t > TIER_MAX)
+			t = TIER_MAX;
+
+		if(t == tier)
+			return;
+
+		if(report)
+			cout << "Quality: tier " << tier << " -> " << t << ", p" << percentile << " " << measured_us << " us of " << budget_us << " us budget" << endl;
+
+		tier = t;
+
+		// Start measuring afresh at the new tier.
+		sample_count = sample_next = 0;
+		over = under = 0;
+
+		// Subscribers may unsubscribe as they're told.
+		auto notify = subscribers;
+		for(auto &it : notify)
+			it.second(tier);
+	}
+
+	void check(uint64_t budget_us){
+		vector<uint64_t> sorted(samples, samples + sample_count);
+		size_t n = min(sorted.size() - 1, (sorted.size() * percentile) / 100);
+
+		nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+		measured_us = sorted[n];
+
+		if(since_up >= 0)
+			since_up++;
+
+		if(measured_us > budget_us){
+			under = 0;
+
+			if(++over >= DOWN_CHECKS){
+				// The last step up didn't hold, so be slower to try again.
+				if((since_up >= 0) && (since_up <= (WINDOW / CHECK_EVERY) * DOWN_CHECKS * 2))
+					up_checks = min(up_checks * 2, (int) UP_CHECKS_MAX);
+
+				since_up = -1;
+				set_tier(tier - 1, budget_us);
+			}
+		} else if(measured_us < (budget_us * headroom / 100)){
+			over = 0;
+
+			if((tier < TIER_MAX) && (++under >= up_checks)){
+				since_up = 0;
+				set_tier(tier + 1, budget_us);
+			}
+		} else {
+			over = under = 0;
+		}
+	}
+
+public:
+	// Percentile of frame times which must fit the budget, and the share of
+	// the budget, in percent, they must fit in before stepping back up.
+	int percentile = 95;
+	int headroom = 70;
+
+	// Print each change of tier.
+	bool report = false;
+
+	static QualityGovernor &inst(){
+		static QualityGovernor *governor = new QualityGovernor();
+		return *governor;
+	}
+
+	int get_tier(){
+		return tier;
+	}
+
+	// Hold the tier, or with -1, let it follow the frame time again.
+	void pin(int t){
+		pinned = t;
+
+		if(t >= 0)
+			set_tier(t, 0);
+
+		up_checks = UP_CHECKS;
+		since_up = -1;
+	}
+	bool is_pinned(){
+		return (pinned >= 0);
+	}
+
+	// Frame time at the chosen percentile, as of the last check.
+	uint64_t frame_time_us(){
+		return measured_us;
+	}
+
+	// Record the time a frame took. With no budget, as when running
+	// unpaced, the tier is left as it is.
+	void frame(uint64_t us, uint64_t budget_us){
+		samples[sample_next] = us;
+		sample_next = ((sample_next + 1) % WINDOW);
+		sample_count = min(sample_count + 1, (int) WINDOW);
+
+		if(--frames_to_check > 0)
+			return;
+
+		frames_to_check = CHECK_EVERY;
+
+		if((pinned < 0) && budget_us && (sample_count >= (WINDOW / 2)))
+			check(budget_us);
+	}
+
+	// Call fn with the current tier now, and again whenever it changes.
+	Subscription subscribe(function<void(int)> fn){
+		Subscription id = subscriber_next++;
+
+		subscribers[id] = fn;
+		fn(tier);
+
+		return id;
+	}
+
+	void unsubscribe(Subscription &id){
+		subscribers.erase(id);
+		id = NONE;
+	}
+};
@@ -0,0 +1,64 @@
+/*
+	Canvas
+	mperron (2026)
+
+	An offscreen SCREEN_WIDTH x SCREEN_HEIGHT render target. When a frame
+	is drawn into the canvas instead of straight to the window, the logical
+	frame can be read back or processed at its native resolution before it
+	is scaled up onto the screen.
+*/
+class Canvas {
+	SDL_Renderer *rend;
+	SDL_Texture *target = NULL;
+	SDL_Texture *target_prev = NULL;
+	bool bound = false;
+
+public:
+	Canvas(SDL_Renderer *rend) :
+		rend(rend)
+	{}
+
+	~Canvas(){
+		if(target)
+			SDL_DestroyTexture(target);
+	}
+
+	// Redirect drawing into the canvas. Returns false if the renderer can't
+	// draw to textures, in which case drawing continues to the window.
+	bool begin(){
+		if(!target && SDL_RenderTargetSupported(rend))
+			target = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+		if(!target)
+			return false;
+
+		target_prev = SDL_GetRenderTarget(rend);
+		bound = !SDL_SetRenderTarget(rend, target);
+
+		return bound;
+	}
+
+	// Copy the logical frame into pixels, in ARGB8888 format. Only valid
+	// between begin() and end().
+	bool read(void *pixels, int pitch){
+		return (bound && !SDL_RenderReadPixels(rend, NULL, SDL_PIXELFORMAT_ARGB8888, pixels, pitch));
+	}
+
+	// Stop drawing into the canvas and return to the previous target.
+	void end(){
+		if(bound){
+			SDL_SetRenderTarget(rend, target_prev);
+			bound = false;
+		}
+	}
+
+	// Scale the canvas onto the current target.
+	void present(){
+		if(target)
+			SDL_RenderCopy(rend, target, NULL, NULL);
+	}
+
+	SDL_Texture *texture(){
+		return target;
+	}
+};
@@ -0,0 +1,227 @@
+/*
+	RendererConfig
+	mperron (2026)
+
+	How the renderer is created: which SDL render driver to use, vsync,
+	render targets and SDL's draw call batching. Settings are kept as
+	key=value lines in renderer.cfg under the save path, e.g.
+
+		driver=opengl
+		vsync=1
+		target_textures=1
+		batching=1
+
+	An empty driver lets SDL choose. Because SDL's choice isn't always the
+	fastest on a given machine, benchmark() can try every available driver
+	on a synthetic workload and pick the quickest one.
+*/
+class RendererConfig {
+public:
+	string driver;
+	bool vsync = false;
+	bool target_textures = true;
+	bool batching = true;
+
+	// Per-frame cost of the driver picked by the most recent benchmark.
+	uint64_t bench_us = 0;
+
+	static string path(){
+		return (get_save_path() + "renderer.cfg");
+	}
+
+	// Called with each renderer just before it's destroyed, to let go of
+	// anything kept for it. Another renderer may be created at the same
+	// address afterwards.
+	static vector<function<void(SDL_Renderer*)>> &on_destroy(){
+		static vector<function<void(SDL_Renderer*)>> *listeners = new vector<function<void(SDL_Renderer*)>>();
+		return *listeners;
+	}
+
+	// Destroy a renderer, and everything the engine keeps for it.
+	static void destroy(SDL_Renderer *rend){
+		for(auto &fn : on_destroy())
+			fn(rend);
+
+		RenderQueue::forget(rend);
+		SDL_DestroyRenderer(rend);
+	}
+
+	// Returns false if there was no saved configuration.
+	bool load(){
+		FILE *infile = fopen(path().c_str(), "r");
+		char line[256];
+
+		if(!infile)
+			return false;
+
+		while(fgets(line, sizeof(line), infile)){
+			string s(line);
+			size_t eq = s.find('=');
+
+			if(eq == string::npos)
+				continue;
+
+			string key = s.substr(0, eq);
+			string value = s.substr(eq + 1);
+
+			while(value.size() && ((value.back() == '\n') || (value.back() == '\r')))
+				value.pop_back();
+
+			if(key == "driver")
+				driver = value;
+			else if(key == "vsync")
+				vsync = (value == "1");
+			else if(key == "target_textures")
+				target_textures = (value == "1");
+			else if(key == "batching")
+				batching = (value == "1");
+		}
+
+		fclose(infile);
+		return true;
+	}
+
+	void save(){
+		FILE *outfile = fopen(path().c_str(), "w");
+
+		if(!outfile){
+			cerr << "Cannot write renderer configuration." << endl;
+			return;
+		}
+
+		fprintf(outfile, "driver=%s\n", driver.c_str());
+		fprintf(outfile, "vsync=%d\n", vsync);
+		fprintf(outfile, "target_textures=%d\n", target_textures);
+		fprintf(outfile, "batching=%d\n", batching);
+		fclose(outfile);
+	}
+
+	// Index of the named render driver, or -1 for SDL's default.
+	static int driver_index(const string &name){
+		for(int i = 0, n = SDL_GetNumRenderDrivers(); i < n; i++){
+			SDL_RendererInfo info;
+
+			if(!SDL_GetRenderDriverInfo(i, &info) && (name == info.name))
+				return i;
+		}
+
+		return -1;
+	}
+
+	// Create a renderer for the window with these settings. If the chosen
+	// driver fails, SDL's default is used instead.
+	SDL_Renderer *create(SDL_Window *win){
+		uint32_t flags = 0;
+		int index = -1;
+
+		SDL_SetHint(SDL_HINT_RENDER_BATCHING, (batching ? "1" : "0"));
+
+		if(vsync)
+			flags |= SDL_RENDERER_PRESENTVSYNC;
+		if(target_textures)
+			flags |= SDL_RENDERER_TARGETTEXTURE;
+
+		if(driver.size() && ((index = driver_index(driver)) < 0))
+			cerr << "No render driver named \"" << driver << "\"." << endl;
+
+		SDL_Renderer *rend = SDL_CreateRenderer(win, index, flags);
+
+		if(!rend && ((index >= 0) || flags)){
+			cerr << "Failed to create renderer: " << SDL_GetError() << endl;
+			rend = SDL_CreateRenderer(win, -1, 0);
+		}
+
+		return rend;
+	}
+
+	// Microseconds per frame of a typical workload on the given driver, or
+	// 0 if the driver couldn't be used. The renderer is thrown away after.
+	uint64_t measure(SDL_Window *win, int index, int frames = 60){
+		SDL_Renderer *rend = SDL_CreateRenderer(win, index, (target_textures ? SDL_RENDERER_TARGETTEXTURE : 0));
+
+		if(!rend)
+			return 0;
+
+		SDL_RenderSetLogicalSize(rend, SCREEN_WIDTH, SCREEN_HEIGHT);
+		SDL_SetRenderDrawBlendMode(rend, SDL_BLENDMODE_BLEND);
+
+		// A small sprite, drawn many times with changing color, much like
+		// text and particles are.
+		uint32_t pixels[16 * 16];
+		SDL_Texture *tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 16, 16);
+		uint64_t result = 0;
+
+		for(int i = 0; i < (16 * 16); i++)
+			pixels[i] = ((i & 1) ? 0xffffffff : 0x80ffffff);
+
+		if(tx){
+			uint64_t freq = SDL_GetPerformanceFrequency();
+			uint64_t start = SDL_GetPerformanceCounter();
+			uint32_t seed = 1;
+			uint32_t probe;
+
+			SDL_UpdateTexture(tx, NULL, pixels, 16 * 4);
+			SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_BLEND);
+
+			for(int f = 0; f < frames; f++){
+				SDL_SetRenderDrawColor(rend, 0, 0, 0, 0xff);
+				SDL_RenderClear(rend);
+
+				for(int i = 0; i < 2000; i++){
+					seed = (seed * 1103515245) + 12345;
+
+					SDL_Rect dst = { (int)((seed >> 8) % SCREEN_WIDTH), (int)((seed >> 16) % SCREEN_HEIGHT), 16, 16 };
+
+					SDL_SetTextureColorMod(tx, seed >> 24, seed >> 16, seed >> 8);
+					SDL_RenderCopy(rend, tx, NULL, &dst);
+				}
+
+				for(int i = 0; i < 200; i++){
+					SDL_Rect rect = { (i * 7) % SCREEN_WIDTH, (i * 13) % SCREEN_HEIGHT, 12, 8 };
+
+					SDL_SetRenderDrawColor(rend, i, 0x80, 0xff - i, 0x80);
+					SDL_RenderFillRect(rend, &rect);
+				}
+
+				SDL_RenderPresent(rend);
+			}
+
+			// Reading a pixel back waits for the GPU to finish its queue.
+			SDL_Rect one = { 0, 0, 1, 1 };
+			SDL_RenderReadPixels(rend, &one, SDL_PIXELFORMAT_ARGB8888, &probe, 4);
+
+			result = max((uint64_t) 1, (SDL_GetPerformanceCounter() - start) * 1000000 / freq / frames);
+			SDL_DestroyTexture(tx);
+		}
+
+		destroy(rend);
+		return result;
+	}
+
+	// Try every available driver and keep the fastest.
+	void benchmark(SDL_Window *win){
+		bench_us = 0;
+
+		for(int i = 0, n = SDL_GetNumRenderDrivers(); i < n; i++){
+			SDL_RendererInfo info;
+
+			if(SDL_GetRenderDriverInfo(i, &info))
+				continue;
+
+			uint64_t us = measure(win, i);
+			cout << "Renderer " << info.name << ": ";
+			if(us)
+				cout << us << " us/frame" << endl;
+			else
+				cout << "unavailable" << endl;
+
+			if(us && (!bench_us || (us < bench_us))){
+				bench_us = us;
+				driver = info.name;
+			}
+		}
+
+		if(bench_us)
+			cout << "Using renderer " << driver << "." << endl;
+	}
+};
@@ -0,0 +1,268 @@
+/*
+	IndexedCanvas
+	mperron (2026)
+
+	An 8-bit palette-indexed framebuffer covering the logical screen. Scenes
+	draw IndexedSprites into it by palette index, and the whole buffer is
+	converted to RGBA through a 256 entry lookup table once per frame, when
+	the canvas itself is drawn. Fades, flashes and palette cycling only
+	rebuild the lookup table, so they cost the same regardless of how much
+	is on screen.
+
+	IndexedSprites keep their pixels as palette indices. A sprite can be
+	drawn with any palette bank by passing an offset, which is added to
+	every opaque index, so one sprite can be recolored without a texture
+	per variation.
+*/
+class IndexedSprite {
+public:
+	int w = 0, h = 0;
+	vector<uint8_t> pixels;
+
+	// Index which is treated as transparent.
+	uint8_t key = 0;
+
+	// The sprite's own palette, if it was loaded from an indexed image.
+	vector<SDL_Color> palette;
+
+	IndexedSprite(int w, int h) :
+		w(w), h(h),
+		pixels(w * h, 0)
+	{}
+
+	// Build a sprite from an 8-bit indexed surface.
+	IndexedSprite(SDL_Surface *sf){
+		if(!sf || (sf->format->BitsPerPixel != 8) || !sf->format->palette){
+			cerr << "IndexedSprite: surface is not 8-bit indexed." << endl;
+			return;
+		}
+
+		w = sf->w;
+		h = sf->h;
+		pixels.resize(w * h);
+
+		SDL_LockSurface(sf);
+		for(int y = 0; y < h; y++)
+			memcpy(&pixels[y * w], ((uint8_t*) sf->pixels) + (y * sf->pitch), w);
+		SDL_UnlockSurface(sf);
+
+		SDL_Palette *pal = sf->format->palette;
+		palette.assign(pal->colors, pal->colors + pal->ncolors);
+	}
+
+	static IndexedSprite *fromBmp(const char *fn){
+		FileLoader *fl = FileLoader::get(fn);
+
+		if(!fl)
+			return NULL;
+
+		return new IndexedSprite(fl->surface());
+	}
+};
+
+class IndexedCanvas : public Drawable {
+	static const int PIXELS = (SCREEN_WIDTH * SCREEN_HEIGHT);
+
+	uint8_t pixels[PIXELS];
+	SDL_Color palette[256];
+	uint32_t lut[256];
+	bool lut_dirty = true;
+
+	SDL_Texture *tx = NULL;
+
+	// Fade towards a color, 0 (none) to 255 (solid color).
+	SDL_Color fade_color = { 0, 0, 0, 0xff };
+	int fade_amount = 0;
+
+	// Full screen flash which decays over flash_time milliseconds.
+	SDL_Color flash_color = { 0xff, 0xff, 0xff, 0xff };
+	int flash_time = 0;
+	int flash_left = 0;
+
+	// Palette cycling over the inclusive range first...last.
+	struct Cycle {
+		uint8_t first, last;
+		int period;
+		int ticks;
+	};
+	vector<Cycle> cycles;
+
+	static uint8_t mix(int a, int b, int amount){
+		return (uint8_t)(a + (((b - a) * amount) / 255));
+	}
+
+	void rebuild_lut(){
+		int flash_amount = (flash_time ? ((flash_left * 255) / flash_time) : 0);
+
+		for(int i = 0; i < 256; i++){
+			SDL_Color c = palette[i];
+
+			if(fade_amount){
+				c.r = mix(c.r, fade_color.r, fade_amount);
+				c.g = mix(c.g, fade_color.g, fade_amount);
+				c.b = mix(c.b, fade_color.b, fade_amount);
+			}
+
+			if(flash_amount){
+				c.r = mix(c.r, flash_color.r, flash_amount);
+				c.g = mix(c.g, flash_color.g, flash_amount);
+				c.b = mix(c.b, flash_color.b, flash_amount);
+			}
+
+			lut[i] = ((0xffu << 24) | (c.r << 16) | (c.g << 8) | c.b);
+		}
+
+		lut_dirty = false;
+	}
+
+	void update_effects(int ticks){
+		if(flash_left > 0){
+			flash_left = max(0, flash_left - ticks);
+			lut_dirty = true;
+		}
+
+		for(Cycle &cycle : cycles){
+			cycle.ticks += ticks;
+
+			// Rotate the range by one entry per period.
+			while(cycle.ticks >= cycle.period){
+				cycle.ticks -= cycle.period;
+
+				SDL_Color last = palette[cycle.last];
+				memmove(&palette[cycle.first + 1], &palette[cycle.first], sizeof(SDL_Color) * (cycle.last - cycle.first));
+				palette[cycle.first] = last;
+
+				lut_dirty = true;
+			}
+		}
+	}
+
+public:
+	IndexedCanvas(SDL_Renderer *rend) :
+		Drawable(rend)
+	{
+		memset(pixels, 0, sizeof(pixels));
+
+		// Default to a grayscale ramp until a palette is loaded.
+		for(int i = 0; i < 256; i++)
+			palette[i] = (SDL_Color){ (uint8_t) i, (uint8_t) i, (uint8_t) i, 0xff };
+
+		tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+	}
+
+	~IndexedCanvas(){
+		if(tx)
+			SDL_DestroyTexture(tx);
+	}
+
+	// Palette.
+	void set_palette_color(uint8_t index, SDL_Color color){
+		palette[index] = color;
+		lut_dirty = true;
+	}
+	void set_palette(const vector<SDL_Color> &colors, uint8_t offset = 0){
+		for(size_t i = 0; (i < colors.size()) && ((offset + i) < 256); i++)
+			palette[offset + i] = colors[i];
+
+		lut_dirty = true;
+	}
+	SDL_Color get_palette_color(uint8_t index) const {
+		return palette[index];
+	}
+
+	// Effects.
+	void set_fade(SDL_Color color, int amount){
+		fade_color = color;
+		fade_amount = max(0, min(255, amount));
+		lut_dirty = true;
+	}
+	void flash(SDL_Color color, int time){
+		flash_color = color;
+		flash_time = flash_left = time;
+		lut_dirty = true;
+	}
+	void cycle(uint8_t first, uint8_t last, int period){
+		if((last > first) && (period > 0))
+			cycles.push_back((Cycle){ first, last, period, 0 });
+	}
+	void cycle_clear(){
+		cycles.clear();
+	}
+
+	// Drawing.
+	void clear(uint8_t index){
+		memset(pixels, index, sizeof(pixels));
+	}
+
+	void fill(SDL_Rect rect, uint8_t index){
+		SDL_Rect screen = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+
+		if(!SDL_IntersectRect(&rect, &screen, &rect))
+			return;
+
+		for(int y = rect.y; y < (rect.y + rect.h); y++)
+			memset(&pixels[(y * SCREEN_WIDTH) + rect.x], index, rect.w);
+	}
+
+	// Draw a sprite with its top left corner at x,y. The bank offset is
+	// added to each opaque index.
+	void blit(const IndexedSprite &sprite, int x, int y, uint8_t bank = 0){
+		int x0 = max(0, -x), y0 = max(0, -y);
+		int x1 = min(sprite.w, SCREEN_WIDTH - x);
+		int y1 = min(sprite.h, SCREEN_HEIGHT - y);
+
+		if((x0 >= x1) || (y0 >= y1))
+			return;
+
+		// Both rows start at the first visible column, so neither pointer
+		// lands outside its buffer.
+		for(int sy = y0; sy < y1; sy++){
+			const uint8_t *src = &sprite.pixels[(sy * sprite.w) + x0];
+			uint8_t *dst = &pixels[((y + sy) * SCREEN_WIDTH) + x + x0];
+
+			for(int sx = 0; sx < (x1 - x0); sx++){
+				uint8_t c = src[sx];
+
+				if(c != sprite.key)
+					dst[sx] = (uint8_t)(c + bank);
+			}
+		}
+	}
+
+	void plot(int x, int y, uint8_t index){
+		if((x >= 0) && (y >= 0) && (x < SCREEN_WIDTH) && (y < SCREEN_HEIGHT))
+			pixels[(y * SCREEN_WIDTH) + x] = index;
+	}
+
+	uint8_t *data(){
+		return pixels;
+	}
+
+	// Advance flashes and palette cycles.
+	void update(int step){
+		update_effects(step);
+	}
+
+	// Convert through the lookup table and draw the whole screen.
+	void draw(int ticks){
+		if(lut_dirty)
+			rebuild_lut();
+
+		void *tx_pixels;
+		int pitch;
+
+		if(!tx || SDL_LockTexture(tx, NULL, &tx_pixels, &pitch))
+			return;
+
+		for(int y = 0; y < SCREEN_HEIGHT; y++){
+			const uint8_t *src = &pixels[y * SCREEN_WIDTH];
+			uint32_t *dst = (uint32_t*)(((uint8_t*) tx_pixels) + (y * pitch));
+
+			for(int x = 0; x < SCREEN_WIDTH; x++)
+				dst[x] = lut[src[x]];
+		}
+
+		SDL_UnlockTexture(tx);
+		SDL_RenderCopy(rend, tx, NULL, NULL);
+	}
+};
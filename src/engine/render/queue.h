@@ -0,0 +1,446 @@
+/*
+	RenderQueue
+	mperron (2026)
+
+	A retained list of compact draw commands, collected once per frame and
+	then executed in a single pass. Commands are ordered by a 64-bit sort
+	key, most significant bits first:
+
+		layer (8) | z (16) | run (16) | pass (2) | texture (14) | state (8)
+
+	A run is the commands of one drawable: Scene::draw starts a new run
+	before each drawable submits, so drawables at the same layer and z
+	are drawn in the order they were submitted, as if drawn immediately.
+	Drawables may instead share a run with the ones before them, by giving
+	them the same draw_batch, so their textures are batched together.
+
+	Within a run, commands are drawn pass by pass, so a drawable can put
+	what must be underneath, such as text shadows, in an earlier pass.
+	Within a pass, untextured commands (rectangles, points and callbacks)
+	keep their submission order and are drawn before textured ones, which
+	are grouped by texture and then by color and blend, to minimize
+	texture switches and state changes. Copies with the same texture and
+	state keep their submission order.
+
+	The key is radix sorted, so thousands of commands cost a few linear
+	passes.
+
+	All per-frame storage comes from a FrameArena, which is rewound after
+	every flush and so stops allocating once it has seen a busy frame.
+
+	A texture which may still be used by queued commands is handed to
+	release(), and destroyed after the next flush for its renderer.
+*/
+class FrameArena {
+	vector<char*> blocks;
+	size_t block_size;
+	size_t used = 0;
+	size_t total = 0;
+	size_t high_water = 0;
+
+	void add_block(size_t size){
+		blocks.push_back((char*) malloc(size));
+		block_size = size;
+		used = 0;
+		total += size;
+	}
+
+public:
+	FrameArena(size_t size = 64 * 1024){
+		add_block(size);
+	}
+
+	~FrameArena(){
+		for(char *block : blocks)
+			free(block);
+	}
+
+	// Allocate bytes aligned to align, which must be a power of two. The
+	// memory is valid until the next call to reset().
+	void *alloc(size_t bytes, size_t align = alignof(max_align_t)){
+		size_t at = (used + (align - 1)) & ~(align - 1);
+
+		if((at + bytes) > block_size){
+			add_block(max(block_size * 2, bytes + align));
+			at = 0;
+		}
+
+		used = at + bytes;
+		high_water = max(high_water, total - block_size + used);
+
+		return blocks.back() + at;
+	}
+
+	template<class T> T *alloc_array(size_t count){
+		return (T*) alloc(sizeof(T) * count, alignof(T));
+	}
+
+	// Release everything allocated since the last reset. If the frame
+	// needed more than one block, they are replaced by a single block big
+	// enough for the whole frame.
+	void reset(){
+		if(blocks.size() > 1){
+			for(char *block : blocks)
+				free(block);
+
+			blocks.clear();
+			total = 0;
+			add_block(high_water);
+		}
+
+		used = 0;
+		high_water = 0;
+	}
+
+	size_t capacity() const { return total; }
+};
+
+struct RenderCommand {
+	enum Kind : uint8_t { COPY, FILL, OUTLINE, POINT, CALLBACK };
+
+	uint8_t kind;
+	bool has_src;
+	uint8_t blend;
+	SDL_Color color;
+	SDL_Texture *tx;
+	SDL_Rect src, dst;
+
+	// Used by CALLBACK commands to defer to immediate-mode drawing.
+	void (*fn)(void*, int);
+	void *ctx;
+	int ticks;
+};
+
+class RenderQueue {
+	struct SortItem {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	SDL_Renderer *rend;
+	FrameArena arena;
+
+	RenderCommand *cmds = NULL;
+	uint64_t *keys = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	size_t capacity_hint = 256;
+
+	uint8_t layer = 0;
+	int16_t z = 0;
+	uint16_t run = 0, run_batch = 0;
+	uint8_t pass = 0;
+
+	// World to screen transform, applied to commands as they're pushed.
+	bool view_active = false;
+	float view_left = 0.0f, view_top = 0.0f, view_scale = 1.0f;
+
+	SDL_Rect to_screen(const SDL_Rect &rect) const {
+		if(!view_active)
+			return rect;
+
+		// Transform both edges, so adjacent rectangles stay adjacent.
+		int x0 = (int) floorf((rect.x - view_left) * view_scale);
+		int y0 = (int) floorf((rect.y - view_top) * view_scale);
+		int x1 = (int) floorf((rect.x + rect.w - view_left) * view_scale);
+		int y1 = (int) floorf((rect.y + rect.h - view_top) * view_scale);
+
+		return (SDL_Rect){ x0, y0, x1 - x0, y1 - y0 };
+	}
+
+	void grow(){
+		size_t capacity_new = max(capacity * 2, capacity_hint);
+		RenderCommand *cmds_new = arena.alloc_array<RenderCommand>(capacity_new);
+		uint64_t *keys_new = arena.alloc_array<uint64_t>(capacity_new);
+
+		if(count){
+			memcpy(cmds_new, cmds, sizeof(RenderCommand) * count);
+			memcpy(keys_new, keys, sizeof(uint64_t) * count);
+		}
+
+		cmds = cmds_new;
+		keys = keys_new;
+		capacity = capacity_new;
+	}
+
+	RenderCommand &push(uint8_t kind, SDL_Texture *tx, SDL_Color color, uint8_t blend){
+		if(count == capacity)
+			grow();
+
+		// Untextured commands leave texture and state at zero so they keep
+		// their submission order within a pass.
+		uint64_t key = (
+			(((uint64_t) layer) << 56) |
+			(((uint64_t) (uint16_t)(z + 0x8000)) << 40) |
+			(((uint64_t) run) << 24) |
+			(((uint64_t) pass) << 22)
+		);
+
+		if(tx){
+			uint32_t texture = ((((uintptr_t) tx) >> 4) & 0x3fff);
+			uint32_t state = (
+				(color.r * 0x1f3du) ^ (color.g * 0x3b1u) ^ (color.b * 0x65u) ^ (color.a << 6)
+			);
+
+			key |= (((uint64_t) (texture ? texture : 1)) << 8);
+			key |= ((state ^ (state >> 8) ^ blend) & 0xff);
+		}
+
+		keys[count] = key;
+
+		RenderCommand &cmd = cmds[count++];
+		cmd.kind = kind;
+		cmd.has_src = false;
+		cmd.blend = blend;
+		cmd.color = color;
+		cmd.tx = tx;
+
+		return cmd;
+	}
+
+	// Stable LSD radix sort on 8-bit digits. Digits which are identical for
+	// every command (usually layer) are skipped.
+	SortItem *sort(){
+		SortItem *a = arena.alloc_array<SortItem>(count);
+		SortItem *b = arena.alloc_array<SortItem>(count);
+		size_t hist[8][256];
+
+		memset(hist, 0, sizeof(hist));
+
+		for(size_t i = 0; i < count; i++){
+			uint64_t key = keys[i];
+
+			a[i].key = key;
+			a[i].index = i;
+
+			for(int d = 0; d < 8; d++)
+				hist[d][(key >> (d * 8)) & 0xff]++;
+		}
+
+		for(int d = 0; d < 8; d++){
+			size_t *h = hist[d];
+
+			// All keys share this digit.
+			if(h[(a[0].key >> (d * 8)) & 0xff] == count)
+				continue;
+
+			size_t sum = 0;
+			for(int i = 0; i < 256; i++){
+				size_t n = h[i];
+
+				h[i] = sum;
+				sum += n;
+			}
+
+			for(size_t i = 0; i < count; i++)
+				b[h[(a[i].key >> (d * 8)) & 0xff]++] = a[i];
+
+			swap(a, b);
+		}
+
+		return a;
+	}
+
+	// Textures to destroy after the next flush, with their renderers.
+	static vector<pair<SDL_Renderer*, SDL_Texture*>> &released(){
+		static vector<pair<SDL_Renderer*, SDL_Texture*>> *textures = new vector<pair<SDL_Renderer*, SDL_Texture*>>();
+		return *textures;
+	}
+
+	static void draw_color(SDL_Renderer *rend, const RenderCommand &cmd){
+		SDL_SetRenderDrawBlendMode(rend, (SDL_BlendMode) cmd.blend);
+		SDL_SetRenderDrawColor(rend, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
+	}
+
+public:
+	// Render cost of the most recent flush.
+	struct Stats {
+		size_t commands = 0;
+		size_t texture_switches = 0;
+		size_t state_changes = 0;
+		uint64_t sort_us = 0;
+		uint64_t execute_us = 0;
+	} stats;
+
+	RenderQueue(SDL_Renderer *rend) :
+		rend(rend)
+	{}
+
+	// Layer and z applied to all commands pushed until the next call.
+	void set_depth(uint8_t layer, int16_t z){
+		this->layer = layer;
+		this->z = z;
+	}
+	uint8_t get_layer() const { return layer; }
+	int16_t get_z() const { return z; }
+
+	// Start a new run, back at pass 0. Commands in earlier runs are drawn
+	// first at the same layer and z; textures are only batched within a
+	// run. A nonzero batch the same as the last run's carries on in that
+	// run instead.
+	void next_run(uint16_t batch = 0){
+		if((!batch || (batch != run_batch) || !run) && (run < 0xffff))
+			run++;
+
+		run_batch = batch;
+		pass = 0;
+	}
+
+	// Pass, from 0 to 3, for the commands which follow in this run. Earlier
+	// passes are drawn first.
+	void set_pass(uint8_t pass){
+		this->pass = (pass & 3);
+	}
+
+	// Treat coordinates of the commands that follow as world coordinates,
+	// with world point left,top at the top left of the screen and scale
+	// screen pixels per world pixel. Callback commands are not transformed,
+	// so Scene::world_add() refuses drawables which submit them.
+	void set_view(float left, float top, float scale){
+		view_active = true;
+		view_left = left;
+		view_top = top;
+		view_scale = scale;
+	}
+	void clear_view(){
+		view_active = false;
+	}
+
+	// Copy all or part of a texture. Color and alpha are applied as texture
+	// modulation when the command is executed.
+	void copy(SDL_Texture *tx, const SDL_Rect *src, const SDL_Rect &dst, SDL_Color color = { 0xff, 0xff, 0xff, 0xff }, SDL_BlendMode blend = SDL_BLENDMODE_BLEND){
+		RenderCommand &cmd = push(RenderCommand::COPY, tx, color, blend);
+
+		if(src){
+			cmd.src = *src;
+			cmd.has_src = true;
+		}
+
+		cmd.dst = to_screen(dst);
+	}
+
+	void fill(const SDL_Rect &dst, SDL_Color color, SDL_BlendMode blend = SDL_BLENDMODE_BLEND){
+		push(RenderCommand::FILL, NULL, color, blend).dst = to_screen(dst);
+	}
+
+	void outline(const SDL_Rect &dst, SDL_Color color, SDL_BlendMode blend = SDL_BLENDMODE_BLEND){
+		push(RenderCommand::OUTLINE, NULL, color, blend).dst = to_screen(dst);
+	}
+
+	void point(int x, int y, SDL_Color color, SDL_BlendMode blend = SDL_BLENDMODE_BLEND){
+		push(RenderCommand::POINT, NULL, color, blend).dst = to_screen((SDL_Rect){ x, y, 1, 1 });
+	}
+
+	// Defer to an immediate-mode draw function, called in sort order.
+	void callback(void (*fn)(void*, int), void *ctx, int ticks){
+		RenderCommand &cmd = push(RenderCommand::CALLBACK, NULL, (SDL_Color){ 0, 0, 0, 0 }, 0);
+
+		cmd.fn = fn;
+		cmd.ctx = ctx;
+		cmd.ticks = ticks;
+	}
+
+	size_t size() const { return count; }
+
+	// Destroy a texture once queued commands are done with it.
+	static void release(SDL_Renderer *rend, SDL_Texture *tx){
+		released().push_back(make_pair(rend, tx));
+	}
+
+	// Destroy the released textures of a renderer which is going away.
+	static void forget(SDL_Renderer *rend){
+		auto &textures = released();
+
+		for(size_t i = 0; i < textures.size();){
+			if(textures[i].first == rend){
+				SDL_DestroyTexture(textures[i].second);
+				textures.erase(textures.begin() + i);
+			} else {
+				i++;
+			}
+		}
+	}
+
+	// Sort and execute every queued command, then empty the queue.
+	void flush(){
+		stats = Stats();
+		stats.commands = count;
+
+		if(count){
+			uint64_t freq = SDL_GetPerformanceFrequency();
+			uint64_t t0 = SDL_GetPerformanceCounter();
+
+			SortItem *order = sort();
+			uint64_t t1 = SDL_GetPerformanceCounter();
+
+			SDL_Texture *tx_last = NULL;
+			SDL_Color color_last = { 0, 0, 0, 0 };
+			uint8_t blend_last = 0;
+
+			for(size_t i = 0; i < count; i++){
+				const RenderCommand &cmd = cmds[order[i].index];
+
+				switch(cmd.kind){
+					case RenderCommand::COPY:
+						if(cmd.tx != tx_last){
+							tx_last = cmd.tx;
+							stats.texture_switches++;
+						} else if((cmd.color != color_last) || (cmd.color.a != color_last.a) || (cmd.blend != blend_last)){
+							stats.state_changes++;
+						} else {
+							SDL_RenderCopy(rend, cmd.tx, (cmd.has_src ? &cmd.src : NULL), &cmd.dst);
+							break;
+						}
+
+						color_last = cmd.color;
+						blend_last = cmd.blend;
+
+						SDL_SetTextureColorMod(cmd.tx, cmd.color.r, cmd.color.g, cmd.color.b);
+						SDL_SetTextureAlphaMod(cmd.tx, cmd.color.a);
+						SDL_SetTextureBlendMode(cmd.tx, (SDL_BlendMode) cmd.blend);
+						SDL_RenderCopy(rend, cmd.tx, (cmd.has_src ? &cmd.src : NULL), &cmd.dst);
+						break;
+
+					case RenderCommand::FILL:
+						draw_color(rend, cmd);
+						SDL_RenderFillRect(rend, &cmd.dst);
+						break;
+
+					case RenderCommand::OUTLINE:
+						draw_color(rend, cmd);
+						SDL_RenderDrawRect(rend, &cmd.dst);
+						break;
+
+					case RenderCommand::POINT:
+						draw_color(rend, cmd);
+						SDL_RenderDrawPoint(rend, cmd.dst.x, cmd.dst.y);
+						break;
+
+					case RenderCommand::CALLBACK:
+						// Immediate-mode drawing may change any texture state.
+						tx_last = NULL;
+						cmd.fn(cmd.ctx, cmd.ticks);
+						break;
+				}
+			}
+
+			// Leave the renderer in the engine's default draw state.
+			SDL_SetRenderDrawBlendMode(rend, SDL_BLENDMODE_BLEND);
+
+			uint64_t t2 = SDL_GetPerformanceCounter();
+			stats.sort_us = (t1 - t0) * 1000000 / freq;
+			stats.execute_us = (t2 - t1) * 1000000 / freq;
+		}
+
+		forget(rend);
+
+		capacity_hint = max(capacity_hint, count);
+		run = run_batch = 0;
+		pass = 0;
+		cmds = NULL;
+		keys = NULL;
+		count = 0;
+		capacity = 0;
+		arena.reset();
+	}
+};
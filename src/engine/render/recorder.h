@@ -0,0 +1,243 @@
+/*
+	Recorder
+	mperron (2026)
+
+	Records the logical SCREEN_WIDTH x SCREEN_HEIGHT frame to disk. Each
+	frame is copied into a ring of buffers on the main thread, and a worker
+	thread encodes and writes them out, so the game loop only pays for the
+	copy. If the writer falls behind and the ring is full, the frame is
+	dropped and counted rather than stalling the game, and the frame before
+	it is written again in its place, so the video keeps its length.
+
+	Video is written at the rate the game is paced to. One frame is
+	recorded per frame drawn, so frames the game itself is too slow to
+	draw on time, or any frame when running unpaced, make the video play
+	faster than the game ran.
+
+	Output formats:
+		RAW     - Concatenated ARGB8888 frames, no header.
+		Y4M     - YUV4MPEG2 stream (4:4:4, BT.601), readable by most tools.
+		BMP     - A numbered image sequence, path000000.bmp, path000001.bmp...
+*/
+class Recorder {
+public:
+	enum Format { RAW, Y4M, BMP };
+
+private:
+	static const int FRAME_PIXELS = (SCREEN_WIDTH * SCREEN_HEIGHT);
+	static const int FRAME_PITCH = (SCREEN_WIDTH * 4);
+
+	string path;
+	Format format;
+	int fps;
+
+	vector<vector<uint32_t>> ring;
+	size_t head = 0, tail = 0, queued = 0;
+
+	// Times to write each slot again, for frames dropped after it.
+	vector<size_t> repeats;
+
+	mutex ring_lock;
+	condition_variable ring_cond;
+	thread writer;
+	bool running = false;
+
+	FILE *out = NULL;
+	vector<uint8_t> planes;
+	atomic<size_t> frames_written{0};
+	atomic<size_t> frames_dropped{0};
+	size_t frames_captured = 0;
+
+	void write_frame(const vector<uint32_t> &frame, size_t number){
+		switch(format){
+			case RAW:
+				fwrite(frame.data(), sizeof(uint32_t), FRAME_PIXELS, out);
+				break;
+
+			case Y4M:
+			{
+				planes.resize(FRAME_PIXELS * 3);
+
+				uint8_t *y = planes.data();
+				uint8_t *u = y + FRAME_PIXELS;
+				uint8_t *v = u + FRAME_PIXELS;
+
+				for(int i = 0; i < FRAME_PIXELS; i++){
+					int r = (frame[i] >> 16) & 0xff;
+					int g = (frame[i] >> 8) & 0xff;
+					int b = frame[i] & 0xff;
+
+					y[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+					u[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+					v[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+				}
+
+				fputs("FRAME\n", out);
+				fwrite(planes.data(), 1, planes.size(), out);
+				break;
+			}
+
+			case BMP:
+			{
+				char fname[16];
+				snprintf(fname, sizeof(fname), "%06zu.bmp", number);
+
+				SDL_Surface *sf = SDL_CreateRGBSurfaceWithFormatFrom(
+					(void*) frame.data(), SCREEN_WIDTH, SCREEN_HEIGHT, 32, FRAME_PITCH, SDL_PIXELFORMAT_ARGB8888
+				);
+
+				if(sf){
+					SDL_SaveBMP(sf, (path + fname).c_str());
+					SDL_FreeSurface(sf);
+				}
+				break;
+			}
+		}
+
+		frames_written++;
+	}
+
+	void writer_main(){
+		size_t number = 0;
+		unique_lock<mutex> lock(ring_lock);
+
+		while(true){
+			ring_cond.wait(lock, [this]{ return (queued || !running); });
+
+			if(!queued)
+				break;
+
+			// The slot at tail belongs to the writer until queued is
+			// decremented, so it can be encoded without holding the lock.
+			vector<uint32_t> &frame = ring[tail];
+			size_t times = 1;
+
+			while(times){
+				lock.unlock();
+
+				for(; times; times--)
+					write_frame(frame, number++);
+
+				// Frames dropped while this one was written repeat it too.
+				lock.lock();
+				swap(times, repeats[tail]);
+			}
+
+			tail = (tail + 1) % ring.size();
+			queued--;
+		}
+	}
+
+public:
+	Recorder(string path, Format format, int fps = SCREEN_FPS, size_t ring_size = 8) :
+		path(path),
+		format(format),
+		fps(fps),
+		ring(ring_size, vector<uint32_t>(FRAME_PIXELS)),
+		repeats(ring_size, 0)
+	{}
+
+	~Recorder(){
+		stop();
+	}
+
+	bool start(){
+		if(running)
+			return true;
+
+		if(format != BMP){
+			out = fopen(path.c_str(), "wb");
+
+			if(!out){
+				cout << "Recorder: cannot open " << path << endl;
+				return false;
+			}
+
+			if(format == Y4M)
+				fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", SCREEN_WIDTH, SCREEN_HEIGHT, fps);
+		}
+
+		head = tail = queued = 0;
+		fill(repeats.begin(), repeats.end(), 0);
+		frames_written = frames_dropped = frames_captured = 0;
+		running = true;
+		writer = thread(&Recorder::writer_main, this);
+
+		return true;
+	}
+
+	// Flush any queued frames and close the output.
+	void stop(){
+		if(!running)
+			return;
+
+		{
+			lock_guard<mutex> lock(ring_lock);
+			running = false;
+		}
+
+		ring_cond.notify_one();
+		writer.join();
+
+		if(out){
+			fclose(out);
+			out = NULL;
+		}
+
+		cout << "Recorder: " << frames_written << " frames written, " << frames_dropped << " dropped." << endl;
+	}
+
+	// Copy the logical frame into the ring. Called once per frame on the
+	// main thread, either with the canvas bound or with a finished frame.
+	void capture(Canvas &canvas){
+		capture_with([&](uint32_t *dst){
+			return canvas.read(dst, FRAME_PITCH);
+		});
+	}
+	void capture(const uint32_t *pixels){
+		capture_with([&](uint32_t *dst){
+			memcpy(dst, pixels, FRAME_PIXELS * sizeof(uint32_t));
+			return true;
+		});
+	}
+
+	template<class F> void capture_with(F fill){
+		if(!running)
+			return;
+
+		frames_captured++;
+
+		size_t slot;
+		{
+			lock_guard<mutex> lock(ring_lock);
+
+			if(queued == ring.size()){
+				// Report drops at most once a second of recorded time.
+				if(!(frames_dropped++ % fps))
+					cout << "Recorder: writer is behind, dropping frames (" << frames_dropped << " dropped)." << endl;
+
+				// Stand in the newest queued frame for this one.
+				repeats[(head + ring.size() - 1) % ring.size()]++;
+				return;
+			}
+
+			slot = head;
+		}
+
+		if(!fill(ring[slot].data()))
+			return;
+
+		{
+			lock_guard<mutex> lock(ring_lock);
+			head = (head + 1) % ring.size();
+			queued++;
+		}
+
+		ring_cond.notify_one();
+	}
+
+	bool recording() const { return running; }
+	size_t get_frames_captured() const { return frames_captured; }
+	size_t get_frames_written() const { return frames_written; }
+	size_t get_frames_dropped() const { return frames_dropped; }
+};
@@ -0,0 +1,342 @@
+/*
+	SpriteSheet, SpriteBatch
+	mperron (2026)
+
+	Frame-by-frame sprite animation. A SpriteSheet is one texture plus a set
+	of named clips, each a list of frames which are regions of that texture.
+	Sheets are described by a small text asset:
+
+		# Comments start with a hash.
+		sheet sprites/hero.bmp
+		clip idle 8 loop
+		frame 0 0 16 16
+		frame 16 0 16 16
+		clip attack 12 once
+		frames 0 16 16 16 6
+
+	"clip <name> <fps> <loop|once>" starts a clip, "frame <x> <y> <w> <h>"
+	adds one frame, and "frames <x> <y> <w> <h> <count>" adds count frames
+	laid out left to right.
+
+	A SpriteBatch owns any number of animated sprites. Their state is kept
+	in flat arrays, so every animation is advanced in one tight pass per
+	update, and the sprites are submitted to the render queue, which groups
+	them by texture and color. Sprites at the same z may then be drawn in
+	any order, so overlapping sprites should be given their own z.
+*/
+class SpriteSheet {
+public:
+	struct Clip {
+		string name;
+		vector<SDL_Rect> frames;
+		int frame_time;
+		bool loop;
+	};
+
+	SDL_Texture *tx = NULL;
+	vector<Clip> clips;
+
+	SpriteSheet(){}
+
+	// The sheet owns its texture, so it can't be copied.
+	SpriteSheet(const SpriteSheet&) = delete;
+	SpriteSheet &operator=(const SpriteSheet&) = delete;
+
+	~SpriteSheet(){
+		if(tx)
+			SDL_DestroyTexture(tx);
+	}
+
+	// Index of the clip with this name, or -1.
+	int clip(const string &name) const {
+		for(size_t i = 0; i < clips.size(); i++)
+			if(clips[i].name == name)
+				return i;
+
+		return -1;
+	}
+
+	static SpriteSheet *load(SDL_Renderer *rend, const char *fn){
+		FileLoader *fl = FileLoader::get(fn);
+
+		if(!fl)
+			return NULL;
+
+		SpriteSheet *sheet = new SpriteSheet();
+		stringstream ss(string(fl->text(), fl->size()));
+		string line;
+		int line_no = 0;
+
+		while(getline(ss, line)){
+			stringstream ls(line);
+			string cmd;
+
+			line_no++;
+
+			if(!(ls >> cmd) || (cmd[0] == '#'))
+				continue;
+
+			if(cmd == "sheet"){
+				string bmp;
+
+				ls >> bmp;
+				sheet->tx = textureFromBmp(rend, bmp.c_str(), true);
+			} else if(cmd == "clip"){
+				Clip clip;
+				int fps = 0;
+				string mode;
+
+				ls >> clip.name >> fps >> mode;
+				clip.frame_time = ((fps > 0) ? max(1, 1000 / fps) : 100);
+				clip.loop = (mode != "once");
+
+				sheet->clips.push_back(clip);
+			} else if(((cmd == "frame") || (cmd == "frames")) && sheet->clips.size()){
+				SDL_Rect frame = { 0, 0, 0, 0 };
+				int count = 1;
+
+				ls >> frame.x >> frame.y >> frame.w >> frame.h;
+				if(cmd == "frames")
+					ls >> count;
+
+				for(int i = 0; i < count; i++, frame.x += frame.w)
+					sheet->clips.back().frames.push_back(frame);
+			} else {
+				cerr << fn << ":" << line_no << ": unknown sprite sheet line." << endl;
+			}
+		}
+
+		// Drop clips with no frames, so every clip can be played safely.
+		for(size_t i = 0; i < sheet->clips.size();){
+			if(sheet->clips[i].frames.empty())
+				sheet->clips.erase(sheet->clips.begin() + i);
+			else
+				i++;
+		}
+
+		return sheet;
+	}
+};
+
+class SpriteBatch : public Drawable {
+public:
+	// Handle to a sprite in the batch. Each handle carries a generation
+	// count, so a stale handle to a removed sprite is harmlessly ignored.
+	typedef uint32_t Sprite;
+
+private:
+	static const uint32_t SLOT_BITS = 20;
+	static const uint32_t SLOT_MASK = ((1 << SLOT_BITS) - 1);
+
+	// Per sprite state, indexed densely. Removing a sprite moves the last
+	// one into its place.
+	vector<const SpriteSheet::Clip*> clip;
+	vector<SDL_Texture*> tx;
+	vector<int> time;
+	vector<uint16_t> frame;
+	vector<uint8_t> playing;
+	vector<SDL_Rect> dst;
+	vector<SDL_Color> color;
+	vector<int16_t> z;
+	vector<uint32_t> dense_slot;
+
+	// Handle slot to dense index, and a generation per slot.
+	vector<uint32_t> slot_dense;
+	vector<uint32_t> slot_gen;
+	vector<uint32_t> slots_free;
+
+	int dense(Sprite sprite) const {
+		uint32_t slot = (sprite & SLOT_MASK);
+
+		if((slot >= slot_gen.size()) || (slot_gen[slot] != (sprite >> SLOT_BITS)))
+			return -1;
+
+		return slot_dense[slot];
+	}
+
+	// Move the last sprite's entry into index i.
+	template<class T>
+	static void move_last(vector<T> &v, size_t i, size_t last){
+		v[i] = v[last];
+		v.pop_back();
+	}
+
+	// Set once update() has been called. Until then, animations advance as
+	// they're drawn.
+	bool update_driven = false;
+
+	// Advance every playing animation by ticks milliseconds.
+	void advance(int ticks){
+		size_t n = clip.size();
+
+		for(size_t i = 0; i < n; i++){
+			if(!playing[i])
+				continue;
+
+			const SpriteSheet::Clip *c = clip[i];
+			int t = time[i] + ticks;
+
+			if((t < c->frame_time) || (c->frame_time <= 0)){
+				time[i] = t;
+				continue;
+			}
+
+			int f = frame[i] + (t / c->frame_time);
+			int frames = c->frames.size();
+			time[i] = (t % c->frame_time);
+
+			if(f >= frames){
+				if(c->loop){
+					f %= frames;
+				} else {
+					f = (frames - 1);
+					playing[i] = 0;
+				}
+			}
+
+			frame[i] = f;
+		}
+	}
+
+public:
+	SpriteBatch(SDL_Renderer *rend) : Drawable(rend) {}
+
+	void update(int step){
+		update_driven = true;
+		advance(step);
+	}
+
+	size_t size() const {
+		return clip.size();
+	}
+
+	Sprite add(const SpriteSheet *sheet, int clip_index, int x, int y){
+		if(!sheet || (clip_index < 0) || ((size_t) clip_index >= sheet->clips.size()))
+			return 0xffffffff;
+
+		uint32_t slot;
+		if(slots_free.size()){
+			slot = slots_free.back();
+			slots_free.pop_back();
+		} else {
+			slot = slot_gen.size();
+			slot_gen.push_back(0);
+			slot_dense.push_back(0);
+		}
+
+		const SpriteSheet::Clip *c = &sheet->clips[clip_index];
+
+		slot_dense[slot] = clip.size();
+		clip.push_back(c);
+		tx.push_back(sheet->tx);
+		time.push_back(0);
+		frame.push_back(0);
+		playing.push_back(1);
+		dst.push_back((SDL_Rect){ x, y, c->frames[0].w, c->frames[0].h });
+		color.push_back((SDL_Color){ 0xff, 0xff, 0xff, 0xff });
+		z.push_back(0);
+		dense_slot.push_back(slot);
+
+		return ((slot_gen[slot] << SLOT_BITS) | slot);
+	}
+
+	void remove(Sprite sprite){
+		int i = dense(sprite);
+		if(i < 0)
+			return;
+
+		uint32_t slot = (sprite & SLOT_MASK);
+		size_t last = (clip.size() - 1);
+
+		move_last(clip, i, last);
+		move_last(tx, i, last);
+		move_last(time, i, last);
+		move_last(frame, i, last);
+		move_last(playing, i, last);
+		move_last(dst, i, last);
+		move_last(color, i, last);
+		move_last(z, i, last);
+		move_last(dense_slot, i, last);
+
+		if((size_t) i < clip.size())
+			slot_dense[dense_slot[i]] = i;
+
+		slot_gen[slot] = ((slot_gen[slot] + 1) & (0xffffffff >> SLOT_BITS));
+		slots_free.push_back(slot);
+	}
+
+	// Restart the sprite on another clip of the same sheet.
+	void play(Sprite sprite, const SpriteSheet *sheet, int clip_index){
+		int i = dense(sprite);
+		if((i < 0) || !sheet || (clip_index < 0) || ((size_t) clip_index >= sheet->clips.size()))
+			return;
+
+		clip[i] = &sheet->clips[clip_index];
+		tx[i] = sheet->tx;
+		time[i] = 0;
+		frame[i] = 0;
+		playing[i] = 1;
+	}
+
+	void set_pos(Sprite sprite, int x, int y){
+		int i = dense(sprite);
+		if(i < 0)
+			return;
+
+		dst[i].x = x;
+		dst[i].y = y;
+	}
+
+	void set_color(Sprite sprite, SDL_Color c){
+		int i = dense(sprite);
+		if(i >= 0)
+			color[i] = c;
+	}
+
+	void set_z(Sprite sprite, int16_t depth){
+		int i = dense(sprite);
+		if(i >= 0)
+			z[i] = depth;
+	}
+
+	// True while a clip which doesn't loop is still playing.
+	bool is_playing(Sprite sprite) const {
+		int i = dense(sprite);
+		return ((i >= 0) && playing[i]);
+	}
+
+	void draw(int ticks){
+		if(!update_driven)
+			advance(ticks);
+
+		for(size_t i = 0; i < clip.size(); i++){
+			const SDL_Rect &src = clip[i]->frames[frame[i]];
+
+			dst[i].w = src.w;
+			dst[i].h = src.h;
+
+			SDL_SetTextureColorMod(tx[i], color[i].r, color[i].g, color[i].b);
+			SDL_SetTextureAlphaMod(tx[i], color[i].a);
+			SDL_RenderCopy(rend, tx[i], &src, &dst[i]);
+		}
+	}
+
+	void submit(RenderQueue &queue, int ticks){
+		if(!update_driven)
+			advance(ticks);
+
+		for(size_t i = 0; i < clip.size(); i++){
+			const SDL_Rect &src = clip[i]->frames[frame[i]];
+
+			dst[i].w = src.w;
+			dst[i].h = src.h;
+
+			queue.set_depth(draw_layer, draw_z + z[i]);
+			queue.copy(tx[i], &src, dst[i], color[i]);
+		}
+	}
+
+	bool submits_commands(){
+		return true;
+	}
+};
@@ -0,0 +1,174 @@
+/*
+	Transition
+	mperron (2026)
+
+	Blends between two scenes entirely on the GPU. The outgoing scene is
+	drawn one last time into a render target texture, and the incoming scene
+	is drawn into a second target every frame until the transition ends. The
+	two are then composited onto the screen, so no pixels are ever read back
+	from the renderer. Progress follows the slide_quad easing curve.
+*/
+class Transition {
+public:
+	enum Style {
+		CUT,
+		CROSSFADE,
+		WIPE_LEFT, WIPE_RIGHT,
+		SLIDE_LEFT, SLIDE_RIGHT, SLIDE_UP, SLIDE_DOWN
+	};
+
+private:
+	SDL_Renderer *rend;
+	SDL_Texture *tx_from = NULL;
+	SDL_Texture *tx_to = NULL;
+
+	Style style = CUT;
+	int time = 0;
+	float progress = 32.0f;
+
+	SDL_Texture *create_target(){
+		SDL_Texture *tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+		if(tx)
+			SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_BLEND);
+
+		return tx;
+	}
+
+	// Draw a scene into one of the render targets, then return to whichever
+	// target was bound before.
+	void render_into(SDL_Texture *target, Drawable *scene, int ticks){
+		SDL_Texture *target_prev = SDL_GetRenderTarget(rend);
+
+		SDL_SetRenderTarget(rend, target);
+		SDL_SetRenderDrawColor(rend, 0, 0, 0, 0xff);
+		SDL_RenderClear(rend);
+
+		if(scene)
+			scene->draw(ticks);
+
+		SDL_SetRenderTarget(rend, target_prev);
+	}
+
+public:
+	Transition(SDL_Renderer *rend) :
+		rend(rend)
+	{}
+
+	~Transition(){
+		if(tx_from)
+			SDL_DestroyTexture(tx_from);
+
+		if(tx_to)
+			SDL_DestroyTexture(tx_to);
+	}
+
+	// Capture the outgoing scene and begin a transition lasting time
+	// milliseconds. Returns false if the renderer can't draw to textures, in
+	// which case the caller should simply cut to the next scene.
+	bool start(Style style, int time, Drawable *scene_from){
+		if((style == CUT) || (time <= 0) || !SDL_RenderTargetSupported(rend))
+			return false;
+
+		if(!tx_from)
+			tx_from = create_target();
+
+		if(!tx_to)
+			tx_to = create_target();
+
+		if(!tx_from || !tx_to)
+			return false;
+
+		this->style = style;
+		this->time = time;
+		progress = 0.0f;
+
+		render_into(tx_from, scene_from, 0);
+		return true;
+	}
+
+	bool active() const {
+		return (progress < 32.0f);
+	}
+
+	// Draw the incoming scene and composite it with the captured outgoing
+	// scene. Once the transition is complete the scene is drawn directly.
+	void draw(Drawable *scene_to, int ticks){
+		if(!active()){
+			if(scene_to)
+				scene_to->draw(ticks);
+
+			return;
+		}
+
+		render_into(tx_to, scene_to, ticks);
+
+		SDL_Rect full = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+		SDL_Rect src = full, dst = full;
+
+		switch(style){
+			case CROSSFADE:
+			{
+				int alpha = slide_quad(0, 0xff, time, ticks, progress);
+
+				SDL_RenderCopy(rend, tx_from, NULL, NULL);
+				SDL_SetTextureAlphaMod(tx_to, alpha);
+				SDL_RenderCopy(rend, tx_to, NULL, NULL);
+				SDL_SetTextureAlphaMod(tx_to, 0xff);
+				break;
+			}
+
+			case WIPE_LEFT:
+			case WIPE_RIGHT:
+			{
+				int edge = slide_quad(0, SCREEN_WIDTH, time, ticks, progress);
+
+				SDL_RenderCopy(rend, tx_from, NULL, NULL);
+
+				src.w = dst.w = edge;
+				if(style == WIPE_LEFT)
+					src.x = dst.x = (SCREEN_WIDTH - edge);
+
+				SDL_RenderCopy(rend, tx_to, &src, &dst);
+				break;
+			}
+
+			case SLIDE_LEFT:
+			case SLIDE_RIGHT:
+			{
+				int offset = slide_quad(0, SCREEN_WIDTH, time, ticks, progress);
+
+				if(style == SLIDE_LEFT)
+					offset = -offset;
+
+				dst.x = offset;
+				SDL_RenderCopy(rend, tx_from, NULL, &dst);
+
+				dst.x = offset + ((style == SLIDE_LEFT) ? SCREEN_WIDTH : -SCREEN_WIDTH);
+				SDL_RenderCopy(rend, tx_to, NULL, &dst);
+				break;
+			}
+
+			case SLIDE_UP:
+			case SLIDE_DOWN:
+			{
+				int offset = slide_quad(0, SCREEN_HEIGHT, time, ticks, progress);
+
+				if(style == SLIDE_UP)
+					offset = -offset;
+
+				dst.y = offset;
+				SDL_RenderCopy(rend, tx_from, NULL, &dst);
+
+				dst.y = offset + ((style == SLIDE_UP) ? SCREEN_HEIGHT : -SCREEN_HEIGHT);
+				SDL_RenderCopy(rend, tx_to, NULL, &dst);
+				break;
+			}
+
+			default:
+				progress = 32.0f;
+				SDL_RenderCopy(rend, tx_to, NULL, NULL);
+				break;
+		}
+	}
+};
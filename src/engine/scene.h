@@ -10,9 +10,42 @@ protected:
 	SDL_Texture *bg = NULL;
 
 	list<Drawable*> drawables;
-	list<Clickable*> clickables;
+	ClickableSet clickables;
 	list<Typable*> typables;
 
+	// Drawables placed in world coordinates, seen through the camera. Only
+	// those in view are drawn.
+	Camera camera;
+	SpatialGrid<Drawable*> world;
+	list<Drawable*> world_unbounded;
+	vector<Drawable*> world_visible;
+
+	void world_add(Drawable *drawable){
+		SDL_Rect rect;
+
+		if(!drawable->submits_commands()){
+			cerr << "Scene: a drawable which draws itself immediately cannot be placed in the world." << endl;
+			return;
+		}
+
+		if(drawable->bounds(rect))
+			world.insert(drawable, rect);
+		else
+			world_unbounded.push_back(drawable);
+	}
+	void world_remove(Drawable *drawable){
+		world.remove(drawable);
+		world_unbounded.remove(drawable);
+	}
+
+	// Call when a world drawable's bounds have changed.
+	void world_moved(Drawable *drawable){
+		SDL_Rect rect;
+
+		if(drawable->bounds(rect))
+			world.update(drawable, rect);
+	}
+
 public:
 	virtual ~Scene(){
 		if(bg)
@@ -24,15 +57,62 @@ public:
 		if(bg)
 			SDL_RenderCopy(rend, bg, NULL, NULL);
 
-		// Draw any drawable elements (buttons, etc.)
+		// Queue up any drawable elements (buttons, etc.) and draw them in
+		// layer and z order.
+		RenderQueue &queue = ctrl->render_queue();
+
+		// World elements are culled to the camera view first.
+		if(world.size() || world_unbounded.size()){
+			queue.set_view(camera.left(), camera.top(), camera.zoom);
+
+			world_visible.clear();
+			world.query(camera.view(), world_visible);
+
+			for(auto drawable : world_unbounded){
+				if(drawable->drawable_hidden)
+					continue;
+
+				queue.next_run(drawable->draw_batch);
+				drawable->submit(queue, ticks);
+			}
+
+			for(auto drawable : world_visible){
+				if(drawable->drawable_hidden)
+					continue;
+
+				queue.next_run(drawable->draw_batch);
+				drawable->submit(queue, ticks);
+			}
+
+			queue.clear_view();
+		}
+
+		for(auto drawable : drawables){
+			if(drawable->drawable_hidden)
+				continue;
+
+			queue.next_run(drawable->draw_batch);
+			drawable->submit(queue, ticks);
+		}
+
+		queue.flush();
+	}
+
+	// Advance every element, including those out of view or hidden.
+	virtual void update(int step){
 		for(auto drawable : drawables)
-			if(!drawable->drawable_hidden)
-				drawable->draw(ticks);
+			drawable->update(step);
+
+		for(auto drawable : world_unbounded)
+			drawable->update(step);
+
+		world.each([step](Drawable *drawable){
+			drawable->update(step);
+		});
 	}
 
 	virtual void check_mouse(SDL_Event event){
-		for(auto clickable : clickables)
-			clickable->check_mouse(event);
+		clickables.check_mouse(event);
 	}
 
 	virtual void keydown(SDL_KeyboardEvent event){
@@ -40,18 +120,96 @@ public:
 			typable->keydown(event);
 	}
 
+	virtual void textinput(SDL_TextInputEvent event){
+		for(auto typable : typables)
+			typable->textinput(event);
+	}
+
 	virtual void receive_data(string const& data){
 	}
 
 	class Controller : public Drawable {
 		Scene *scene_next = NULL;
-		map<int, bool> *keys = NULL;
+		InputState *input_state = NULL;
+
+		// Mouse motion not yet sent to the scene.
+		SDL_Event motion;
+		bool motion_pending = false;
 		list<Scene*> scene_stack;
+		bool quit_requested = false;
 
 		SDL_Texture *mouse_tx;
 
+		// Hardware cursor, and the scale it was built for. A scale it
+		// couldn't be built for isn't tried again until the scale changes.
+		bool cursor_hardware = false;
+		SDL_Cursor *cursor_hw = NULL;
+		int cursor_hw_scale = 0;
+		int cursor_hw_failed = 0;
+		bool cursor_hw_shown = false;
+
+		// Build the hardware cursor from the cursor image, scaled to match
+		// the size of a logical pixel on screen. If it can't be built, the
+		// cursor is drawn into the frame instead.
+		void cursor_hw_update(){
+			int out_w = 0, out_h = 0;
+
+			SDL_GetRendererOutputSize(rend, &out_w, &out_h);
+			int scale = max(1, min(out_w / SCREEN_WIDTH, out_h / SCREEN_HEIGHT));
+
+			if((cursor_hw && (scale == cursor_hw_scale)) || (scale == cursor_hw_failed))
+				return;
+
+			FileLoader *fl = FileLoader::get("mouse/cursor.bmp");
+			SDL_Surface *sf = (fl ? fl->surface() : NULL);
+			SDL_Cursor *cursor = NULL;
+
+			if(sf){
+				SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, mouse_cursor.w * scale, mouse_cursor.h * scale, 32, SDL_PIXELFORMAT_ARGB8888);
+
+				if(scaled){
+					SDL_SetColorKey(sf, SDL_TRUE, SDL_MapRGB(sf->format, 0xff, 0x00, 0xff));
+					SDL_FillRect(scaled, NULL, 0);
+					SDL_BlitScaled(sf, NULL, scaled, NULL);
+
+					cursor = SDL_CreateColorCursor(scaled, 0, 0);
+					SDL_FreeSurface(scaled);
+				}
+			}
+
+			// A cursor built for another scale would be the wrong size.
+			if(cursor_hw)
+				SDL_FreeCursor(cursor_hw);
+
+			cursor_hw = cursor;
+
+			if(cursor){
+				SDL_SetCursor(cursor);
+				cursor_hw_scale = scale;
+				cursor_hw_failed = 0;
+			} else {
+				cursor_hw_failed = scale;
+			}
+		}
+
 		int volume = 128;
 
+		RenderQueue queue;
+
+		Transition transition;
+		Transition::Style transition_style = Transition::CUT;
+		int transition_time = 0;
+
+		// Scenes are updated in fixed steps of update_step milliseconds, with
+		// the time not yet used carried over in update_acc_us.
+		int update_step = 10;
+		int update_steps_max = 10;
+		uint64_t update_acc_us = 0;
+
+		Canvas canvas;
+		Recorder *recorder = NULL;
+		PostChain *post = NULL;
+
 	public:
 		int render_scale;
 		const int render_scale_max;
@@ -63,12 +221,22 @@ public:
 		bool mouse_enabled = true;
 		SDL_Rect mouse_cursor;
 
-		Controller(SDL_Window *win, SDL_Renderer *rend, int scale, int scale_max, map<int, bool> *keys) :
+		// Holds the game loop to its frame rate.
+		FramePacer pacer;
+
+		// Length of the current frame in microseconds. draw() is given whole
+		// milliseconds, for anything which needs finer timing.
+		uint64_t frame_us = 0;
+
+		Controller(SDL_Window *win, SDL_Renderer *rend, int scale, int scale_max, InputState *input_state) :
 			Drawable(rend),
+			queue(rend),
+			transition(rend),
+			canvas(rend),
 			render_scale(scale),
 			render_scale_max(scale_max)
 		{
-			this->keys = keys;
+			this->input_state = input_state;
 			this->win = win;
 
 			// Mouse cursor is a 14x14 pixel image.
@@ -77,8 +245,25 @@ public:
 		}
 
 		~Controller(){
+			record_stop();
+
+			for(Scene *it : scene_stack)
+				if(it != scene)
+					delete it;
+
+			if(scene_next && (scene_next != scene))
+				delete scene_next;
+			if(scene)
+				delete scene;
+
+			if(post)
+				delete post;
+
 			if(mouse_tx)
 				SDL_DestroyTexture(mouse_tx);
+
+			if(cursor_hw)
+				SDL_FreeCursor(cursor_hw);
 		}
 
 		void set_render_scale(int scale){
@@ -107,10 +292,23 @@ public:
 			return rend;
 		}
 
+		// Commands submitted by the current scene. The stats member holds the
+		// cost of the last flush.
+		RenderQueue &render_queue(){
+			return queue;
+		}
+
 		void set_scene(Scene *scene){
 			this->scene_next = scene;
 		}
 
+		// Blend into the next scene set by set_scene(), scene_descend() or
+		// scene_ascend(), over time milliseconds.
+		void set_transition(Transition::Style style, int time){
+			transition_style = style;
+			transition_time = time;
+		}
+
 		// Save the current scene onto the scene stack and descend into a new sub-scene.
 		void scene_descend(Scene *scene){
 			scene_stack.push_back(this->scene);
@@ -139,11 +337,71 @@ public:
 			return scene_ascend("");
 		}
 
+		// The program's timer wheel, which this controller advances on
+		// update steps.
+		TimerWheel &timers(){
+			return TimerWheel::inst();
+		}
+
+#ifdef __cpp_impl_coroutine
+		// co_await to resume after ms milliseconds of updates.
+		TimerWheel::Sleep sleep(int ms){
+			return TimerWheel::inst().sleep(ms);
+		}
+		TimerWheel::Sleep sleep(chrono::milliseconds ms){
+			return TimerWheel::inst().sleep(ms);
+		}
+#endif
+
+		// Step length in milliseconds for update().
+		void set_update_step(int ms){
+			update_step = max(1, ms);
+		}
+		int get_update_step(){
+			return update_step;
+		}
+
+		// Run as many fixed steps of the scene as fit in the time which has
+		// passed. If the game falls too far behind, the time it can't catch
+		// up on is dropped, so a slow frame doesn't lead to a slower one.
+		void update(uint64_t us){
+			uint64_t step_us = ((uint64_t) update_step * 1000);
+			int steps = 0;
+
+			update_acc_us += us;
+
+			while(update_acc_us >= step_us){
+				// Keys as they stand for this step. Only the first step after
+				// a press or release sees it, and frames which run no steps
+				// leave theirs for the next one.
+				if(input_state)
+					input_state->publish();
+
+				TimerWheel::inst().advance(update_step);
+
+				if(scene && !scene_next)
+					scene->update(update_step);
+
+				update_acc_us -= step_us;
+
+				if(++steps >= update_steps_max){
+					update_acc_us %= step_us;
+					break;
+				}
+			}
+
+			Drawable::render_alpha = ((float) update_acc_us / step_us);
+		}
+
 		void draw(int ticks){
 			if(scene_next){
 				if(scene){
 					bool scene_on_stack = false;
 
+					// Capture the outgoing scene before it can be deleted.
+					transition.start(transition_style, transition_time, scene);
+					transition_style = Transition::CUT;
+
 					for(Scene *it : scene_stack){
 						if(it == scene){
 							scene_on_stack = true;
@@ -160,43 +418,176 @@ public:
 				scene_next = NULL;
 			}
 
+			// Bring moved elements and their children up to date.
+			TransformTree::inst().update();
+
 			SDL_SetRenderDrawColor(rend, 0, 0, 0, 0xff);
 			SDL_RenderClear(rend);
 
-			if(scene)
-				scene->draw(ticks);
+			// Draw into the offscreen canvas if anything needs the logical frame.
+			bool post_active = (post && post->active());
+			bool offscreen = ((recorder || post_active) && canvas.begin());
+			if(offscreen)
+				SDL_RenderClear(rend);
+
+			transition.draw(scene, ticks);
+
+			if(offscreen){
+				bool processed = false;
+				if(post_active){
+					HitchZone zone("post");
+					processed = post->process(canvas);
+				}
+
+				if(recorder){
+					if(processed)
+						recorder->capture(post->pixels());
+					else
+						recorder->capture(canvas);
+				}
+
+				canvas.end();
+
+				if(processed)
+					post->present();
+				else
+					canvas.present();
+			}
+		}
+
+		// Full screen effects applied to every frame, created on first use.
+		PostChain *post_chain(){
+			if(!post)
+				post = new PostChain(rend);
+
+			return post;
+		}
+
+		// Record every frame to path until record_stop() is called. Encoding
+		// and disk writes happen on a separate thread.
+		bool record_start(string path, Recorder::Format format){
+			record_stop();
+
+			recorder = new Recorder(path, format, ((pacer.get_rate() > 0) ? pacer.get_rate() : SCREEN_FPS));
+			if(recorder->start())
+				return true;
+
+			delete recorder;
+			recorder = NULL;
+
+			return false;
+		}
+		void record_stop(){
+			if(recorder){
+				delete recorder;
+				recorder = NULL;
+			}
 		}
 
 		void draw_cursor(){
+			bool show = (mouse_enabled && !scene_next && (SDL_GetRelativeMouseMode() != SDL_TRUE));
+
+			// The system draws the hardware cursor, so it moves without
+			// waiting for the next frame.
+			if(cursor_hardware){
+				if(show)
+					cursor_hw_update();
+
+				show = (show && cursor_hw);
+
+				if(show != cursor_hw_shown){
+					SDL_ShowCursor(show ? SDL_ENABLE : SDL_DISABLE);
+					cursor_hw_shown = show;
+				}
+
+				if(cursor_hw)
+					return;
+			}
+
 			// Draw mouse cursor
-			if(mouse_enabled && !scene_next && (SDL_GetRelativeMouseMode() != SDL_TRUE))
+			if(show)
 				SDL_RenderCopy(rend, mouse_tx, NULL, &mouse_cursor);
 		}
 
+		// Use the system's cursor, with our cursor image, instead of drawing
+		// the cursor into each frame. Falls back to drawing the cursor if the
+		// system cursor can't be created.
+		void set_cursor_hardware(bool enable){
+			cursor_hardware = enable;
+
+			if(!enable && cursor_hw_shown){
+				SDL_ShowCursor(SDL_DISABLE);
+				cursor_hw_shown = false;
+			}
+		}
+
+		// Stop once this frame is done. The game loop shuts down cleanly, so
+		// scenes are destroyed as usual.
 		void quit(){
-			exit(0);
+			quit_requested = true;
+		}
+		bool quitting(){
+			return quit_requested;
 		}
 
+		// Motion is held back and merged, so that however many motion
+		// events arrive in a frame, the scene sees one. Any other mouse
+		// event sends the motion before it first, to keep the order.
 		void check_mouse(SDL_Event event){
 			if(event.type == SDL_MOUSEMOTION){
 				// Move cursor to point position.
 				mouse_cursor.x = event.motion.x;
 				mouse_cursor.y = event.motion.y;
+
+				if(motion_pending){
+					event.motion.xrel += motion.motion.xrel;
+					event.motion.yrel += motion.motion.yrel;
+				}
+
+				motion = event;
+				motion_pending = true;
+				return;
 			}
 
+			mouse_flush();
+
 			if(mouse_enabled && scene)
 				scene->check_mouse(event);
 		}
 
+		// Send on any motion held back. Called once events for the frame
+		// have been handled.
+		void mouse_flush(){
+			if(!motion_pending)
+				return;
+
+			motion_pending = false;
+
+			if(mouse_enabled && scene)
+				scene->check_mouse(motion);
+		}
+
 		// Get the up/down state of a key. True if keydown.
 		bool keystate(int keysym){
-			return (*keys)[keysym];
+			return input_state->down_key(keysym);
+		}
+
+		// Keyboard state and actions, as of the latest update step.
+		const InputSnapshot &input(){
+			return input_state->get();
+		}
+		InputState &input_bindings(){
+			return *input_state;
 		}
 
 		void keydown(SDL_KeyboardEvent event){
 			scene->keydown(event);
 		}
 
+		void textinput(SDL_TextInputEvent event){
+			scene->textinput(event);
+		}
+
 		void set_volume(int vol){
 			volume = vol;
 			Mix_Volume(-1, volume);
@@ -205,8 +596,32 @@ public:
 			return volume;
 		}
 
+		// Draws the current scene into a new SCREEN_WIDTH x SCREEN_HEIGHT
+		// texture without reading anything back from the renderer. Returns
+		// NULL if the renderer doesn't support render targets.
+		SDL_Texture *snapshot(){
+			if(!scene || !SDL_RenderTargetSupported(rend))
+				return NULL;
+
+			SDL_Texture *tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+			if(tx){
+				SDL_Texture *target_prev = SDL_GetRenderTarget(rend);
+
+				SDL_SetRenderTarget(rend, tx);
+				SDL_SetRenderDrawColor(rend, 0, 0, 0, 0xff);
+				SDL_RenderClear(rend);
+				scene->draw(0);
+				SDL_SetRenderTarget(rend, target_prev);
+			}
+
+			return tx;
+		}
+
 		// Takes a screenshot and returns it as a texture. Captured dimensions
-		// returned with w,h members of SDL_Rect dimensions.
+		// returned with w,h members of SDL_Rect dimensions. This reads the
+		// whole window back from the renderer and stalls until the GPU is
+		// done; prefer snapshot() or set_transition() where possible.
 		SDL_Texture *screencap(SDL_Rect &dimensions){
 			int px_w = (SCREEN_WIDTH * render_scale);
 			int px_h = (SCREEN_HEIGHT * render_scale);
@@ -244,7 +659,7 @@ public:
 
 			if(cap){
 				SDL_RenderReadPixels(rend, NULL, format, cap->pixels, cap->pitch);
-				SDL_Texture *tx = SDL_CreateTextureFromSurface(rend, cap);
+				SDL_Texture *tx = HitchDetector::create_texture(rend, cap);
 				SDL_FreeSurface(cap);
 
 				return tx;
@@ -257,6 +672,9 @@ public:
 protected:
 	Controller *ctrl;
 
+	// Name the scene was registered under, if it was made by create().
+	string name;
+
 	Scene(Controller *ctrl) :
 		Drawable(ctrl->renderer())
 	{
@@ -277,6 +695,10 @@ protected:
 public:
 	static void reg(string, Scene* (*fn)(Controller*));
 	static Scene *create(Controller *ctrl, string);
+
+	const string &get_name(){
+		return name;
+	}
 };
 
 map<string, Scene::SceneFn*> Scene::scenes;
@@ -286,10 +708,14 @@ void Scene::reg(string name, Scene* (*fn)(Scene::Controller*)){
 Scene *Scene::create(Scene::Controller *ctrl, string name){
 	Scene::SceneFn *fn = scenes[name];
 
-	if(fn)
-		return fn->fn(ctrl);
+	if(!fn)
+		return NULL;
+
+	Scene *scene = fn->fn(ctrl);
+	if(scene)
+		scene->name = name;
 
-	return NULL;
+	return scene;
 }
 
 template<class T> Scene *scene_create(Scene::Controller *ctrl){
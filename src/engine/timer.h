@@ -0,0 +1,319 @@
+/*
+	TimerWheel
+	mperron (2026)
+
+	Timers for things which happen after a delay, such as blinking text or
+	a button which becomes clickable again. Rather than each element
+	counting down every frame, a timer is only touched when it is due, so
+	elements with nothing pending cost nothing.
+
+	Timers sit in a hierarchical wheel: four levels of 64 slots, each slot
+	of a level spanning a whole turn of the level below. A timer is placed
+	by how far away it is, and is moved down a level each time the wheel
+	turns over, so adding, cancelling and running a timer are all constant
+	time however many there are. The wheel runs in milliseconds and covers
+	about four and a half hours; timers further out are placed at the top
+	level and moved along until they come into range.
+
+	There is one wheel for the whole program, reached with inst(), as
+	widgets are built from a renderer alone and have no controller to ask.
+	The scene controller advances it with each update step. Timers are
+	named by handles, which stay safe to cancel after the timer has run.
+
+	With C++20 coroutines, a TimerTask can wait on the wheel:
+
+		TimerTask flash(){
+			co_await TimerWheel::inst().sleep(200ms);
+			...
+		}
+*/
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+class TimerWheel {
+public:
+	typedef uint32_t Timer;
+	static const Timer NONE = 0xffffffff;
+
+private:
+	static const int LEVELS = 4;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = (1 << SLOT_BITS);
+	static const int SLOT_MASK = (SLOTS - 1);
+
+	static const int INDEX_BITS = 20;
+	static const uint32_t INDEX_MASK = ((1 << INDEX_BITS) - 1);
+
+	struct Node {
+		uint64_t expire;
+		uint32_t interval;
+		uint32_t gen;
+		function<void()> fn;
+
+		// Links in the slot list, or in the free list.
+		int32_t prev, next;
+		int16_t level, slot;
+	};
+
+	vector<Node> nodes;
+	int32_t nodes_free = -1;
+	size_t count = 0;
+
+	int32_t heads[LEVELS][SLOTS];
+	uint64_t now = 0;
+
+	// Node index for a handle, or -1 if the timer has run or was cancelled.
+	int32_t find(Timer timer){
+		uint32_t index = (timer & INDEX_MASK);
+
+		if((timer == NONE) || (index >= nodes.size()))
+			return -1;
+
+		Node &n = nodes[index];
+		if((n.gen != (timer >> INDEX_BITS)) || (n.level < 0))
+			return -1;
+
+		return index;
+	}
+
+	void link(int32_t id){
+		Node &n = nodes[id];
+		uint64_t delta = ((n.expire > now) ? (n.expire - now) : 0);
+		uint64_t expire = n.expire;
+
+		int level = 0;
+		while((level < (LEVELS - 1)) && (delta >= ((uint64_t) 1 << (SLOT_BITS * (level + 1)))))
+			level++;
+
+		// Beyond the top of the wheel, park it as far out as it reaches.
+		if(delta >= ((uint64_t) 1 << (SLOT_BITS * LEVELS)))
+			expire = (now + ((uint64_t) 1 << (SLOT_BITS * LEVELS)) - 1);
+
+		int slot = ((expire >> (SLOT_BITS * level)) & SLOT_MASK);
+
+		n.level = level;
+		n.slot = slot;
+		n.prev = -1;
+		n.next = heads[level][slot];
+
+		if(n.next >= 0)
+			nodes[n.next].prev = id;
+
+		heads[level][slot] = id;
+	}
+
+	void unlink(int32_t id){
+		Node &n = nodes[id];
+
+		if(n.prev >= 0)
+			nodes[n.prev].next = n.next;
+		else
+			heads[n.level][n.slot] = n.next;
+
+		if(n.next >= 0)
+			nodes[n.next].prev = n.prev;
+
+		n.level = -1;
+	}
+
+	void release(int32_t id){
+		Node &n = nodes[id];
+
+		n.fn = nullptr;
+		n.gen = ((n.gen + 1) & (0xffffffff >> INDEX_BITS));
+		n.next = nodes_free;
+		nodes_free = id;
+		count--;
+	}
+
+	// Run the timers due at the current tick, first moving down any which
+	// are coming into range as the wheel turns over.
+	void tick(){
+		for(int level = 1; level < LEVELS; level++){
+			if(now & (((uint64_t) 1 << (SLOT_BITS * level)) - 1))
+				break;
+
+			int slot = ((now >> (SLOT_BITS * level)) & SLOT_MASK);
+			int32_t id = heads[level][slot];
+			heads[level][slot] = -1;
+
+			while(id >= 0){
+				int32_t next = nodes[id].next;
+
+				link(id);
+				id = next;
+			}
+		}
+
+		int32_t *head = &heads[0][now & SLOT_MASK];
+
+		// Timers may add or cancel others as they run, so the list is taken
+		// one timer at a time.
+		while(*head >= 0){
+			int32_t id = *head;
+			unlink(id);
+
+			if(nodes[id].expire > now){
+				link(id);
+				continue;
+			}
+
+			// The function is moved out, since it may add timers and move
+			// the node array.
+			function<void()> fn;
+			fn.swap(nodes[id].fn);
+
+			if(nodes[id].interval){
+				Timer timer = handle(id);
+
+				nodes[id].expire = (now + nodes[id].interval);
+				link(id);
+				fn();
+
+				// Unless it cancelled itself, give it back its function.
+				int32_t still = find(timer);
+				if(still >= 0)
+					nodes[still].fn.swap(fn);
+			} else {
+				release(id);
+				fn();
+			}
+		}
+	}
+
+	Timer handle(int32_t id){
+		return ((nodes[id].gen << INDEX_BITS) | id);
+	}
+
+	Timer add(uint64_t delay, uint32_t interval, function<void()> fn){
+		int32_t id;
+
+		if(nodes_free >= 0){
+			id = nodes_free;
+			nodes_free = nodes[id].next;
+		} else {
+			id = nodes.size();
+
+			if((uint32_t) id >= INDEX_MASK)
+				return NONE;
+
+			nodes.push_back(Node());
+			nodes[id].gen = 0;
+		}
+
+		Node &n = nodes[id];
+		n.expire = (now + max(delay, (uint64_t) 1));
+		n.interval = interval;
+		n.fn = fn;
+
+		link(id);
+		count++;
+
+		return handle(id);
+	}
+
+	TimerWheel(){
+		for(int level = 0; level < LEVELS; level++)
+			for(int slot = 0; slot < SLOTS; slot++)
+				heads[level][slot] = -1;
+	}
+
+public:
+	static TimerWheel &inst(){
+		static TimerWheel *wheel = new TimerWheel();
+		return *wheel;
+	}
+
+	// Call fn once, ms milliseconds from now.
+	Timer after(int ms, function<void()> fn){
+		return add(max(ms, 0), 0, fn);
+	}
+
+	// Call fn every ms milliseconds, until it is cancelled.
+	Timer every(int ms, function<void()> fn){
+		ms = max(ms, 1);
+		return add(ms, ms, fn);
+	}
+
+	// Stop a timer. Returns false if it had already run or been cancelled.
+	bool cancel(Timer timer){
+		int32_t id = find(timer);
+
+		if(id < 0)
+			return false;
+
+		unlink(id);
+		release(id);
+		return true;
+	}
+
+	// Cancel the timer and clear the handle.
+	void cancel_clear(Timer &timer){
+		cancel(timer);
+		timer = NONE;
+	}
+
+	bool pending(Timer timer){
+		return (find(timer) >= 0);
+	}
+
+	size_t size(){
+		return count;
+	}
+
+	// Milliseconds the wheel has run for.
+	uint64_t time(){
+		return now;
+	}
+
+	// Move the wheel on by ms milliseconds, running every timer which comes
+	// due on the way.
+	void advance(int ms){
+		for(; ms > 0; ms--){
+			now++;
+
+			if(count)
+				tick();
+		}
+	}
+
+#ifdef __cpp_impl_coroutine
+	struct Sleep {
+		TimerWheel *wheel;
+		int ms;
+
+		bool await_ready(){
+			return (ms <= 0);
+		}
+		void await_suspend(coroutine_handle<> h){
+			wheel->after(ms, [h](){
+				h.resume();
+			});
+		}
+		void await_resume(){}
+	};
+
+	// co_await to resume after ms milliseconds.
+	Sleep sleep(int ms){
+		return (Sleep){ this, ms };
+	}
+	Sleep sleep(chrono::milliseconds ms){
+		return sleep((int) ms.count());
+	}
+#endif
+};
+
+#ifdef __cpp_impl_coroutine
+// A coroutine which starts straight away and cleans up after itself when
+// it finishes. Nothing waits on it.
+struct TimerTask {
+	struct promise_type {
+		TimerTask get_return_object(){ return TimerTask(); }
+		suspend_never initial_suspend(){ return suspend_never(); }
+		suspend_never final_suspend() noexcept { return suspend_never(); }
+		void return_void(){}
+		void unhandled_exception(){ terminate(); }
+	};
+};
+#endif
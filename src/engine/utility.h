@@ -19,7 +19,7 @@ SDL_Texture *textureFromBmp(SDL_Renderer *rend, const char *fn, bool trans = fal
 	if(sf && trans)
 		SDL_SetColorKey(sf, SDL_TRUE, SDL_MapRGB(sf->format, 0xff, 0x00, 0xff));
 
-	SDL_Texture *tx = SDL_CreateTextureFromSurface(rend, sf);
+	SDL_Texture *tx = HitchDetector::create_texture(rend, sf);
 
 	return tx;
 }
@@ -0,0 +1,62 @@
+/*
+	Camera
+	mperron (2026)
+
+	A view into world coordinates. The camera position is the world point at
+	the center of the screen, and zoom is the number of screen pixels per
+	world pixel. If bounds has a size, the view is kept inside it.
+*/
+class Camera {
+	void clamp(){
+		if((bounds.w <= 0) || (bounds.h <= 0))
+			return;
+
+		float half_w = SCREEN_WIDTH / (2.0f * zoom);
+		float half_h = SCREEN_HEIGHT / (2.0f * zoom);
+
+		x = ((bounds.w > (2 * half_w)) ? max(bounds.x + half_w, min(bounds.x + bounds.w - half_w, x)) : (bounds.x + bounds.w / 2.0f));
+		y = ((bounds.h > (2 * half_h)) ? max(bounds.y + half_h, min(bounds.y + bounds.h - half_h, y)) : (bounds.y + bounds.h / 2.0f));
+	}
+
+public:
+	float x = SCREEN_WIDTH / 2.0f;
+	float y = SCREEN_HEIGHT / 2.0f;
+	float zoom = 1.0f;
+	SDL_Rect bounds = { 0, 0, 0, 0 };
+
+	void set_position(float x, float y){
+		this->x = x;
+		this->y = y;
+		clamp();
+	}
+	void move(float dx, float dy){
+		set_position(x + dx, y + dy);
+	}
+
+	void set_zoom(float zoom){
+		this->zoom = max(0.01f, zoom);
+		clamp();
+	}
+
+	void set_bounds(SDL_Rect bounds){
+		this->bounds = bounds;
+		clamp();
+	}
+
+	// World coordinates of the top left corner of the screen.
+	float left() const { return x - (SCREEN_WIDTH / (2.0f * zoom)); }
+	float top() const { return y - (SCREEN_HEIGHT / (2.0f * zoom)); }
+
+	// The area of the world which is on screen.
+	SDL_Rect view() const {
+		return (SDL_Rect){
+			(int) floorf(left()), (int) floorf(top()),
+			(int) ceilf(SCREEN_WIDTH / zoom) + 1, (int) ceilf(SCREEN_HEIGHT / zoom) + 1
+		};
+	}
+
+	void to_world(int screen_x, int screen_y, float &world_x, float &world_y) const {
+		world_x = left() + (screen_x / zoom);
+		world_y = top() + (screen_y / zoom);
+	}
+};
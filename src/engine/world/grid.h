@@ -0,0 +1,211 @@
+/*
+	SpatialGrid
+	mperron (2026)
+
+	A uniform grid over 2D space for finding items by area. Each item is
+	stored with its bounding rectangle in every cell that rectangle touches,
+	so a query only looks at the items in the cells it overlaps, however
+	many items there are elsewhere. Cells are hashed, so the grid has no
+	fixed extent.
+
+	Query results are returned in insertion order.
+*/
+template<class T> class SpatialGrid {
+	struct Entry {
+		T item;
+		SDL_Rect rect;
+		int cx0, cy0, cx1, cy1;
+		uint64_t seq;
+		uint32_t stamp;
+	};
+
+	int cell_size;
+	vector<Entry> entries;
+	vector<int> entries_free;
+	unordered_map<T, int> index;
+	unordered_map<uint64_t, vector<int>> cells;
+
+	uint64_t seq_next = 0;
+	uint32_t stamp = 0;
+	vector<int> found;
+
+	static uint64_t cell_key(int cx, int cy){
+		return ((((uint64_t)(uint32_t) cx) << 32) | (uint32_t) cy);
+	}
+
+	int cell_of(int v) const {
+		// Round towards negative infinity, so negative coordinates work.
+		return ((v >= 0) ? (v / cell_size) : (((v + 1) / cell_size) - 1));
+	}
+
+	void cells_add(int id){
+		Entry &e = entries[id];
+
+		for(int cy = e.cy0; cy <= e.cy1; cy++)
+			for(int cx = e.cx0; cx <= e.cx1; cx++)
+				cells[cell_key(cx, cy)].push_back(id);
+	}
+
+	void cells_remove(int id){
+		Entry &e = entries[id];
+
+		for(int cy = e.cy0; cy <= e.cy1; cy++){
+			for(int cx = e.cx0; cx <= e.cx1; cx++){
+				auto it = cells.find(cell_key(cx, cy));
+
+				if(it == cells.end())
+					continue;
+
+				vector<int> &ids = it->second;
+				for(size_t i = 0; i < ids.size(); i++){
+					if(ids[i] == id){
+						ids[i] = ids.back();
+						ids.pop_back();
+						break;
+					}
+				}
+
+				if(ids.empty())
+					cells.erase(it);
+			}
+		}
+	}
+
+	void set_rect(Entry &e, const SDL_Rect &rect){
+		e.rect = rect;
+		e.cx0 = cell_of(rect.x);
+		e.cy0 = cell_of(rect.y);
+		e.cx1 = cell_of(rect.x + max(1, rect.w) - 1);
+		e.cy1 = cell_of(rect.y + max(1, rect.h) - 1);
+	}
+
+public:
+	SpatialGrid(int cell_size = 64) :
+		cell_size(cell_size)
+	{}
+
+	size_t size() const {
+		return index.size();
+	}
+
+	bool contains(T item) const {
+		return (index.find(item) != index.end());
+	}
+
+	void insert(T item, const SDL_Rect &rect){
+		if(contains(item)){
+			update(item, rect);
+			return;
+		}
+
+		int id;
+		if(entries_free.size()){
+			id = entries_free.back();
+			entries_free.pop_back();
+		} else {
+			id = entries.size();
+			entries.push_back(Entry());
+		}
+
+		Entry &e = entries[id];
+		e.item = item;
+		e.seq = seq_next++;
+		e.stamp = stamp;
+		set_rect(e, rect);
+
+		index[item] = id;
+		cells_add(id);
+	}
+
+	// Move an item. Cells are only touched if it crossed a cell boundary.
+	void update(T item, const SDL_Rect &rect){
+		auto it = index.find(item);
+
+		if(it == index.end()){
+			insert(item, rect);
+			return;
+		}
+
+		int id = it->second;
+		Entry &e = entries[id];
+		Entry moved = e;
+		set_rect(moved, rect);
+
+		if((moved.cx0 != e.cx0) || (moved.cy0 != e.cy0) || (moved.cx1 != e.cx1) || (moved.cy1 != e.cy1)){
+			cells_remove(id);
+			entries[id] = moved;
+			cells_add(id);
+		} else {
+			e.rect = rect;
+		}
+	}
+
+	void remove(T item){
+		auto it = index.find(item);
+
+		if(it == index.end())
+			return;
+
+		int id = it->second;
+		cells_remove(id);
+		index.erase(it);
+		entries_free.push_back(id);
+	}
+
+	// Append every item whose rectangle overlaps rect to out.
+	void query(const SDL_Rect &rect, vector<T> &out){
+		int cx0 = cell_of(rect.x), cx1 = cell_of(rect.x + max(1, rect.w) - 1);
+		int cy0 = cell_of(rect.y), cy1 = cell_of(rect.y + max(1, rect.h) - 1);
+
+		// Stamp entries as they're found, so items spanning several cells
+		// are only reported once.
+		if(!++stamp){
+			for(Entry &e : entries)
+				e.stamp = 0;
+
+			stamp = 1;
+		}
+
+		found.clear();
+
+		for(int cy = cy0; cy <= cy1; cy++){
+			for(int cx = cx0; cx <= cx1; cx++){
+				auto it = cells.find(cell_key(cx, cy));
+
+				if(it == cells.end())
+					continue;
+
+				for(int id : it->second){
+					Entry &e = entries[id];
+
+					if(e.stamp == stamp)
+						continue;
+
+					e.stamp = stamp;
+
+					if(SDL_HasIntersection(&e.rect, &rect))
+						found.push_back(id);
+				}
+			}
+		}
+
+		sort(found.begin(), found.end(), [this](int a, int b){
+			return (entries[a].seq < entries[b].seq);
+		});
+
+		for(int id : found)
+			out.push_back(entries[id].item);
+	}
+
+	// Append every item containing the point x,y to out.
+	void query_point(int x, int y, vector<T> &out){
+		query((SDL_Rect){ x, y, 1, 1 }, out);
+	}
+
+	// Call f on every item, in no particular order.
+	template<typename F>
+	void each(F f){
+		for(auto &it : index)
+			f(it.first);
+	}
+};
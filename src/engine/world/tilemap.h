@@ -0,0 +1,276 @@
+/*
+	TileMap
+	mperron (2026)
+
+	A grid of tiles drawn from a single tileset texture. Tiles are stored
+	as 16-bit indices, grouped by chunk of CHUNK x CHUNK tiles so each chunk
+	is contiguous in memory. Chunks in view are baked into their own
+	textures, so a screen of tiles costs a handful of copies instead of one
+	per tile. Changing a tile only re-bakes its chunk.
+
+	Chunk textures are pooled; when the pool is full, the least recently
+	drawn chunk gives up its texture. At most bake_budget chunks are baked
+	per frame, and chunks past the budget are drawn tile by tile until a
+	later frame gets to them, so fast scrolling doesn't hitch.
+
+	Below full quality the map leans harder on its bakes, so each frame
+	draws less. The bake budget doubles with each tier down, so fewer
+	chunks are drawn tile by tile while scrolling, and a chunk whose tiles
+	change keeps showing its last bake for a few frames before it's baked
+	again, rather than being re-baked or drawn tile by tile on every edit.
+	The pool stays the same size at every tier.
+
+	Tile 0 is empty. Tile n is cell n - 1 of the tileset, counted left to
+	right and top to bottom.
+*/
+class TileMap : public Drawable {
+public:
+	static const int CHUNK = 16;
+
+private:
+	struct Chunk {
+		int slot = -1;
+		bool dirty = true;
+
+		// Whether the slot holds this chunk's tiles, if perhaps out of date,
+		// and the frame they were baked.
+		bool baked = false;
+		uint32_t baked_at = 0;
+	};
+
+	struct Slot {
+		SDL_Texture *tx;
+		int chunk;
+		uint32_t last_used;
+	};
+
+	int w, h;
+	int chunks_w, chunks_h;
+	int tile_w, tile_h;
+
+	SDL_Texture *tileset;
+	int tileset_cols;
+
+	vector<uint16_t> tiles;
+	vector<Chunk> chunks;
+	vector<Slot> slots;
+
+	uint32_t frame = 0;
+	int bakes_left = 0;
+
+	int tier = QualityGovernor::TIER_MAX;
+	QualityGovernor::Subscription quality;
+
+	// Top left corner of the screen, in map pixels.
+	int view_x = 0, view_y = 0;
+
+	size_t tile_index(int x, int y) const {
+		int chunk = ((y / CHUNK) * chunks_w) + (x / CHUNK);
+		return ((size_t) chunk * CHUNK * CHUNK) + ((y % CHUNK) * CHUNK) + (x % CHUNK);
+	}
+
+	void tile_src(uint16_t tile, SDL_Rect &src) const {
+		src.x = ((tile - 1) % tileset_cols) * tile_w;
+		src.y = ((tile - 1) / tileset_cols) * tile_h;
+		src.w = tile_w;
+		src.h = tile_h;
+	}
+
+	// Draw every tile of a chunk with its top left corner at x,y.
+	void draw_tiles(int chunk, int x, int y){
+		const uint16_t *t = &tiles[(size_t) chunk * CHUNK * CHUNK];
+		SDL_Rect src, dst = { 0, 0, tile_w, tile_h };
+
+		for(int ty = 0; ty < CHUNK; ty++){
+			for(int tx = 0; tx < CHUNK; tx++){
+				uint16_t tile = t[(ty * CHUNK) + tx];
+
+				if(!tile)
+					continue;
+
+				tile_src(tile, src);
+				dst.x = x + (tx * tile_w);
+				dst.y = y + (ty * tile_h);
+
+				SDL_RenderCopy(rend, tileset, &src, &dst);
+			}
+		}
+	}
+
+	// Find a texture for the chunk, evicting the least recently used one
+	// if the pool is full. Returns -1 if no texture can be had.
+	int acquire_slot(int chunk){
+		int slot = -1;
+
+		if(slots.size() < max_chunks){
+			SDL_Texture *tx = HitchDetector::create_texture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, CHUNK * tile_w, CHUNK * tile_h);
+
+			if(tx){
+				SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_BLEND);
+				slots.push_back((Slot){ tx, -1, 0 });
+				slot = (slots.size() - 1);
+			}
+		}
+
+		if(slot < 0){
+			uint32_t oldest = frame;
+
+			for(size_t i = 0; i < slots.size(); i++){
+				if(slots[i].last_used < oldest){
+					oldest = slots[i].last_used;
+					slot = i;
+				}
+			}
+
+			if(slot < 0)
+				return -1;
+
+			chunks[slots[slot].chunk].slot = -1;
+			chunks[slots[slot].chunk].baked = false;
+		}
+
+		slots[slot].chunk = chunk;
+		chunks[chunk].slot = slot;
+		chunks[chunk].dirty = true;
+		chunks[chunk].baked = false;
+
+		return slot;
+	}
+
+	void bake(int chunk){
+		SDL_Texture *target_prev = SDL_GetRenderTarget(rend);
+
+		SDL_SetRenderTarget(rend, slots[chunks[chunk].slot].tx);
+		SDL_SetRenderDrawColor(rend, 0, 0, 0, 0);
+		SDL_RenderClear(rend);
+		draw_tiles(chunk, 0, 0);
+		SDL_SetRenderTarget(rend, target_prev);
+
+		chunks[chunk].dirty = false;
+		chunks[chunk].baked = true;
+		chunks[chunk].baked_at = frame;
+		bakes++;
+	}
+
+public:
+	// Most chunk textures to keep, and most chunks to bake in a frame.
+	size_t max_chunks = 64;
+	int bake_budget = 4;
+
+	// Statistics for the most recent frame.
+	int chunks_drawn = 0;
+	int bakes = 0;
+
+	TileMap(SDL_Renderer *rend, int w, int h, SDL_Texture *tileset, int tile_w, int tile_h) :
+		Drawable(rend),
+		w(w), h(h),
+		chunks_w((w + CHUNK - 1) / CHUNK),
+		chunks_h((h + CHUNK - 1) / CHUNK),
+		tile_w(tile_w), tile_h(tile_h),
+		tileset(tileset),
+		tiles((size_t) chunks_w * chunks_h * CHUNK * CHUNK, 0),
+		chunks(chunks_w * chunks_h)
+	{
+		int tileset_w = 0;
+
+		SDL_QueryTexture(tileset, NULL, NULL, &tileset_w, NULL);
+		tileset_cols = max(1, tileset_w / tile_w);
+
+		quality = QualityGovernor::inst().subscribe([this](int t){
+			tier = t;
+		});
+	}
+
+	~TileMap(){
+		QualityGovernor::inst().unsubscribe(quality);
+
+		for(Slot &slot : slots)
+			SDL_DestroyTexture(slot.tx);
+	}
+
+	int get_w() const { return w; }
+	int get_h() const { return h; }
+
+	uint16_t get_tile(int x, int y) const {
+		if((x < 0) || (y < 0) || (x >= w) || (y >= h))
+			return 0;
+
+		return tiles[tile_index(x, y)];
+	}
+
+	void set_tile(int x, int y, uint16_t tile){
+		if((x < 0) || (y < 0) || (x >= w) || (y >= h))
+			return;
+
+		uint16_t &t = tiles[tile_index(x, y)];
+
+		if(t != tile){
+			t = tile;
+			chunks[((y / CHUNK) * chunks_w) + (x / CHUNK)].dirty = true;
+		}
+	}
+
+	// Move the view so that map pixel x,y is at the top left of the screen.
+	void set_view(int x, int y){
+		view_x = x;
+		view_y = y;
+	}
+	int get_view_x() const { return view_x; }
+	int get_view_y() const { return view_y; }
+
+	void draw(int ticks){
+		int chunk_pw = (CHUNK * tile_w), chunk_ph = (CHUNK * tile_h);
+		bool targets = SDL_RenderTargetSupported(rend);
+
+		frame++;
+		int steps_down = (QualityGovernor::TIER_MAX - tier);
+		uint32_t rebake_frames = (1 << steps_down);
+
+		bakes_left = (bake_budget << steps_down);
+		chunks_drawn = bakes = 0;
+
+		// Only chunks overlapping the screen are considered.
+		int cx0 = max(0, view_x / chunk_pw), cx1 = min(chunks_w - 1, (view_x + SCREEN_WIDTH - 1) / chunk_pw);
+		int cy0 = max(0, view_y / chunk_ph), cy1 = min(chunks_h - 1, (view_y + SCREEN_HEIGHT - 1) / chunk_ph);
+
+		for(int cy = cy0; cy <= cy1; cy++){
+			for(int cx = cx0; cx <= cx1; cx++){
+				int chunk = ((cy * chunks_w) + cx);
+				int x = ((cx * chunk_pw) - view_x), y = ((cy * chunk_ph) - view_y);
+				Chunk &c = chunks[chunk];
+
+				chunks_drawn++;
+
+				if(targets && ((c.slot >= 0) || (bakes_left > 0))){
+					if((c.slot >= 0) || (acquire_slot(chunk) >= 0)){
+						if(c.dirty){
+							// Below full quality, an edited chunk shows its last
+							// bake until it's due to be baked again.
+							bool stale = (c.baked && steps_down);
+
+							if((bakes_left > 0) && !(stale && ((frame - c.baked_at) < rebake_frames))){
+								bakes_left--;
+								bake(chunk);
+							} else if(!stale){
+								// Keep the slot for next frame's bake, rather than
+								// letting another visible chunk take it.
+								slots[c.slot].last_used = frame;
+								draw_tiles(chunk, x, y);
+								continue;
+							}
+						}
+
+						Slot &slot = slots[c.slot];
+						SDL_Rect dst = { x, y, chunk_pw, chunk_ph };
+
+						slot.last_used = frame;
+						SDL_RenderCopy(rend, slot.tx, NULL, &dst);
+						continue;
+					}
+				}
+
+				draw_tiles(chunk, x, y);
+			}
+		}
+	}
+};